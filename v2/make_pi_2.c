@@ -51,6 +51,9 @@ int main (int argc, char * argv[])
             iterations = 20000L;
         }
     }
+    // Simpson's Rule works on pairs of steps, so there have to be an even
+    // number of them
+    iterations = iterations + (iterations % 2L);
     long num_threads = 8L;
     if (argc > 2) {
         num_threads = atol (argv[2]);
@@ -137,24 +140,30 @@ void * calculate (void * args)
     limits * funct_args = (limits *)args;
     long double trap = 0.0L, mid = 0.0L;
     long double inverseiterations = 1.0L / (long double)funct_args->totaliterations;
+    long double twoiterations = 2.0L * inverseiterations;
     long i;
-    long k = funct_args->lowlimit;
-    long double inc = (inverseiterations / 2.0L) + inverseiterations * (long double)k;
     
+    // Simpson's Rule takes the steps two at a time: the even points are the
+    // ends of each pair, which the trapezoid rule uses, and the odd points
+    // are their middles, which the midpoint rule uses. Every point belongs to
+    // exactly one of the two, so each one is only worked out once.
     for (i = funct_args->lowlimit; i < funct_args->highlimit; i++) {
-        // First, the trapezoid rule is used to estimate pi
-        long double leftrect = (long double)k * inverseiterations;
-        k++;
-        long double rightrect = (long double)k * inverseiterations;
-        long double trapsquared = ((leftrect + rightrect) / 2.0L) * ((leftrect + rightrect) / 2.0L);
-        long double traptemp = (1.0L / (1.0L + trapsquared)) * inverseiterations;
-        trap = trap + traptemp;
-        
-        // Next, the midpoint rule is also used to estimate pi
-        long double inctemp = inc;
-        inc = inc + inverseiterations;
-        long double midtemp = (1.0L / (1.0L + (inctemp * inctemp))) * inverseiterations;
-        mid = mid + midtemp;
+        long double x = (long double)i * inverseiterations;
+        long double term = (1.0L / (1.0L + (x * x))) * twoiterations;
+        if (i == 0L) {
+            // The trapezoid rule counts the ends of the integral half as much
+            trap = trap + (term / 2.0L);
+        } else if ((i % 2L) == 0L) {
+            trap = trap + term;
+        } else {
+            mid = mid + term;
+        }
+    }
+    
+    // The other end of the integral goes to whichever thread has the last
+    // iteration, and is also counted half as much
+    if (funct_args->highlimit == funct_args->totaliterations) {
+        trap = trap + ((1.0L / 2.0L) * twoiterations / 2.0L);
     }
     
     // Save partial result and exit
@@ -50,30 +50,229 @@ echo " "
 mpiexec -np 96 ./make_pi_6 10000000000 50
 echo " "
 
+The long additions and subtractions, and the multiplications by a single
+limb, have versions for AVX2 and AVX-512, and each process picks the fastest
+one its processor can run when it starts. A third argument (generic, avx2 or
+avx512) forces one of them instead, and "make_pi_6 bench avx2" times the
+bignum methods with that one.
+Putting "euler" and an order in front of the arguments, as in
+"make_pi_6 euler 6 10000 60", corrects the trapezoid rule at its ends with
+the Euler-Maclaurin formula instead of using Simpson's Rule. Or, put
+"romberg" in place of the iterations to use Romberg's method, with the
+number of levels, the digits, and optionally a file to save its progress in,
+which a later run with more levels picks up from:
+mpiexec -np 96 ./make_pi_6 romberg 24 100 pi.state
+
 */
 
 // Includes
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
 #include "mpi.h"
 
-// A bignum is stored as all its decimal digits, separated into an array.
-// Really, it's quite terrible for performance, but it allows infinite digits.
-// Or at least as many as we can store in memory. The power tells us where to
-// put the decimal point, and the number of significant digits tells us how
-// many of the digits in the number are actually used. The precision tells us
-// the maximum number of digits possible for this particular instance.
+// A bignum is stored as an array of "limbs," each of which holds nine decimal
+// digits (a value from 0 to 999,999,999). Storing a whole machine word's worth
+// of digits per slot means every loop does about a ninth of the work it did
+// back when we stored one decimal digit per char, and since each limb is just
+// nine decimal digits, printing stays cheap. The product of two limbs always
+// fits in 64 bits, so we don't need any compiler-specific 128-bit types. The
+// limbs are stored least significant first. The power tells us where to put
+// the decimal point, counted in limbs: the most significant limb is worth
+// (10^9)^power. The number of significant digits tells us how many limbs are
+// actually used, and the precision tells us the maximum number of limbs
+// possible for this particular instance. The limbs only ever hold the size of
+// the number; whether it's negative is a separate flag, and zero is never
+// negative.
+#define LIMB_DIGITS 9L
+#define LIMB_BASE 1000000000U
+typedef uint32_t limb;
+
+// Once the shorter operand of a multiplication has this many limbs, we switch
+// from the schoolbook method to Karatsuba, then to Toom-3, and then to NTT.
+// These were picked by running the program with "bench" as its only
+// argument, which times all four methods across a range of sizes. NTT only
+// pulls ahead at 2048 limbs; at 1024 and 1536 Toom-3 still wins. Your
+// mileage may vary on different hardware.
+#define KARATSUBA_THRESHOLD 24L
+#define TOOM3_THRESHOLD 256L
+#define NTT_THRESHOLD 2048L
+
+// Squaring with the schoolbook method only takes about half the limb
+// products, so it stays ahead of Karatsuba for longer.
+#define SQUARE_KARATSUBA_THRESHOLD 48L
+
+// Adding or subtracting words this long is split into blocks of 64 limbs: one
+// pass adds the limbs without carrying, the carries for the whole block are
+// then worked out at once with a little bit arithmetic, and a second pass
+// adds them in. Both passes are independent limb by limb, so the compiler
+// can vectorize them, but it only pays off when it has AVX2 (or better) to
+// do it with. Otherwise, the plain carry loop is faster.
+#define CARRY_LOOKAHEAD_THRESHOLD 32L
+
+// Multiplying a word this long by a single limb (and adding or subtracting
+// the product) is split the same way: the limb products are divided by B
+// all at once into their low and high halves, and then those are added
+// together with the same carry lookahead. Below it, the plain loop, which
+// divides each product in turn, is faster. So is it everywhere with just
+// AVX2, except for word_submul_1, whose plain loop has to branch on every
+// limb. AVX-512 speeds up all three.
+#define MULTIPLY_SPLIT_THRESHOLD 32L
+
+// So that one binary can use AVX2 or AVX-512 where it's there without
+// needing it everywhere, the word kernels that can use them (the additions
+// and subtractions underneath bignum_add, Karatsuba, Toom-3, and the
+// division's corrections, and the single-limb multiplications underneath the
+// schoolbook products and long division) come in a few versions, and
+// word_kernels_init points a word_kernel_set at the best one the processor
+// has when the program starts. GCC and Clang can build a single function for
+// another instruction set (GCC also has to be told to vectorize it, since
+// -O1 and -O2 mostly won't), so there, every version is always built and the
+// processor is asked which it can run. Other compilers build everything for
+// the same instruction set, so a version is only offered if the whole
+// program was built for it (with /arch:AVX2, say).
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WORD_KERNELS_PER_FUNCTION 1
+#if defined(__clang__)
+#define WORD_TARGET_AVX2 __attribute__((target("avx2")))
+#define WORD_TARGET_AVX512 \
+    __attribute__((target("avx2,avx512f,avx512bw,avx512vl")))
+#else
+#define WORD_TARGET_AVX2 \
+    __attribute__((target("avx2"), optimize("tree-vectorize")))
+#define WORD_TARGET_AVX512 \
+    __attribute__((target("avx2,avx512f,avx512bw,avx512vl"), \
+    optimize("tree-vectorize")))
+#endif
+#else
+#define WORD_KERNELS_PER_FUNCTION 0
+#define WORD_TARGET_AVX2
+#define WORD_TARGET_AVX512
+#endif
+
+// The plain loops each version is made of are written once, and forced
+// inline, so each version gets its own copy built for its instruction set.
+#if defined(_MSC_VER)
+#define WORD_INLINE static __forceinline
+#elif defined(__GNUC__)
+#define WORD_INLINE static inline __attribute__((always_inline))
+#else
+#define WORD_INLINE static inline
+#endif
+
+// One version of the word kernels. The name is what to give on the command
+// line to force it.
+typedef struct {
+    const char * name;
+    limb (*add_n)(limb *, const limb *, const limb *, long int);
+    limb (*sub_n)(limb *, const limb *, const limb *, long int);
+    limb (*mul_1)(limb *, const limb *, long int, limb);
+    limb (*addmul_1)(limb *, const limb *, long int, limb);
+    limb (*submul_1)(limb *, const limb *, long int, limb);
+} word_kernel_set;
+extern word_kernel_set word_kernels;
+
+// Once both the denominator and the quotient of a division have this many
+// limbs, bignum_divide multiplies by a reciprocal found with Newton's method
+// instead of doing long division. Also picked with "bench".
+#define NEWTON_THRESHOLD 256L
+
+// Adding up a run of terms by binary splitting (fixed_ratio_series) only
+// does one division in the end, but the fraction it divides grows by a limb
+// or two for every term, so it only beats dividing out each term on its own
+// once the numbers have at least SERIES_THRESHOLD limbs, and there are no
+// more than SERIES_TERMS_PER_LIMB terms for each of those limbs. These came
+// from timing both ways over a range of term counts and lengths.
+#define SERIES_THRESHOLD 512L
+#define SERIES_TERMS_PER_LIMB 64L
+
+// Romberg's method can go this many levels deep (2^31 steps) before the
+// 4^level - 1 it divides by at the last level no longer fits in 64 bits.
+// Where a long int is only 32 bits, though, 2^31 steps won't fit in one, so
+// it stops a level short. It carries this many guard digits, which covers
+// both the truncation in every term it has added up by then and the
+// extrapolation on top.
+#define ROMBERG_MAX_LEVELS ((sizeof(long int) > 4U) ? 31L : 30L)
+#define ROMBERG_GUARD_DIGITS 24L
+
+// The three primes used for NTT multiplication. Each one is of the form
+// k * 2^j + 1, which means it has a 2^j-th root of unity (powers of 3 work for
+// all of them), so the transform length can go up to the smallest 2^j. Their
+// product is about 7.9 * 10^25, comfortably bigger than any single column of
+// a product of two words that short can add up to.
+#define NTT_PRIME_1 998244353U
+#define NTT_PRIME_2 167772161U
+#define NTT_PRIME_3 469762049U
+#define NTT_ROOT 3U
+#define NTT_MAX_LENGTH 8388608L
+
+// Scratch space for the temporary words the bignum functions (and the word
+// functions underneath them) need. Rather than going to malloc and free on
+// every multiply and divide (with every thread fighting over the allocator
+// at once), each worker makes one arena up front, big enough for any
+// temporary at its precision, and hands it to its bignums. Temporaries are
+// taken from the front and given back in the reverse order, so the arena is
+// empty again after every operation. Anything that doesn't fit, or a bignum
+// without an arena, just falls back to malloc.
+typedef struct {
+    limb * space;
+    long int size;
+    long int used;
+} bignum_arena;
+
+// The arena, if there is one, is where any function storing into this bignum
+// gets its scratch space from.
 typedef struct {
     signed long int power;
     unsigned long int sig_digs;
-    char * digits;
+    limb * digits;
     unsigned long int precision;
+    bignum_arena * arena;
+    int negative;
 } bignum;
 
+// A fixed-point number, for when we know a value will always be between 0
+// and 4 (which is true of everything in the Simpson's Rule calculation). The
+// limbs are stored least significant first like a bignum's, but the top limb
+// is always the whole part and all the others are fractional, so there's no
+// power to line up and no significant digits to keep track of: every fixed
+// number of the same length lines up limb for limb. The arena works the same
+// way it does for a bignum.
+typedef struct {
+    limb * digits;
+    long int length;
+    bignum_arena * arena;
+} fixed;
+
+// A whole number of the form base^2 + index^2, kept as a word so it can't
+// overflow, which can be stepped from one index to the next by just adding
+// 2 * index + 1. Every term of our sum is a whole number over one of these,
+// so this gives us each denominator in a couple of limb additions.
+#define SQUARE_SUM_LIMBS 7L
+typedef struct {
+    limb digits[SQUARE_SUM_LIMBS];
+    long int index;
+} square_sum;
+
+// A running total of fixed numbers. Each limb is 64 bits instead of 32, so
+// adding a fixed number into it is just adding limb to limb, with no carries:
+// a limb starts out under B and gains less than B per addition, so it has
+// room for billions of them. The carries are only sorted out (normalized)
+// when we want the total back as a fixed number, or once count reaches
+// FIXED_SUM_LIMIT, long before anything could overflow.
+#define FIXED_SUM_LIMIT 1073741824L
+typedef struct {
+    uint64_t * digits;
+    long int length;
+    long int count;
+} fixed_sum;
+
 // Function pointers, mostly for bignum operations. Note that in our use
 // below, we assume most of the arithmetic functions don't fail and thus 
 // don't check their return values. Hope they're tested well...
+int romberg_main (int, char * [], int, int);
 bignum * bignum_init(long int);
 void bignum_reset(bignum *);
 void bignum_clear(bignum *);
@@ -81,12 +280,112 @@ int bignum_set_int(bignum *, long int);
 void bignum_set(bignum *, bignum *);
 void bignum_print(bignum *, long int);
 int bignum_add(bignum *, bignum *, bignum *);
+int bignum_sub(bignum *, bignum *, bignum *);
+int bignum_add_signed(bignum *, bignum *, bignum *, int);
 int bignum_add_int(bignum *, bignum *, long int);
+int bignum_cmp(bignum *, bignum *);
+int bignum_cmp_magnitude(bignum *, bignum *);
+void bignum_place(limb *, long int, long int, bignum *);
 int bignum_mult(bignum *, bignum *, bignum *);
+int bignum_square(bignum *, bignum *);
 int bignum_mult_int(bignum *, bignum *, long int);
 int bignum_divide(bignum *, bignum *, bignum *);
 int bignum_int_divide(bignum *, long int, bignum *);
 int bignum_divide_int(bignum *, bignum *, long int);
+void bignum_divide_limb(bignum *, limb *, long int, long int, limb);
+fixed * fixed_init(long int);
+void fixed_clear(fixed *);
+void fixed_set_int(fixed *, long int);
+void fixed_set(fixed *, fixed *);
+void fixed_print(fixed *, long int);
+int fixed_add(fixed *, fixed *, fixed *);
+int fixed_sub(fixed *, fixed *, fixed *);
+int fixed_mult_int(fixed *, fixed *, long int);
+int fixed_divide_int(fixed *, fixed *, long int);
+int fixed_divide_word(fixed *, fixed *, limb *, long int);
+fixed_sum * fixed_sum_init(long int);
+void fixed_sum_clear(fixed_sum *);
+void fixed_sum_add(fixed_sum *, fixed *);
+void fixed_sum_normalize(fixed_sum *);
+void fixed_sum_get(fixed *, fixed_sum *);
+int fixed_ratio(fixed *, long int, limb *, long int);
+int fixed_ratio_words(fixed *, limb *, long int, limb *, long int);
+void square_sum_init(square_sum *, long int, long int);
+void square_sum_next(square_sum *);
+int fixed_ratio_series(fixed *, long int, long int, long int, long int,
+    long int);
+int word_series_split(limb **, long int *, limb **, long int *, long int,
+    long int, long int, long int);
+int fixed_sum_add_ratios(fixed_sum *, fixed *, long int, long int, long int,
+    long int, long int);
+int romberg_extend(fixed **, long int, fixed *);
+int romberg_save(const char *, fixed **, long int);
+long int romberg_load(const char *, fixed **, long int);
+void word_tangent_numbers(limb *, long int, long int);
+int fixed_euler_maclaurin(fixed *, long int, long int);
+long int bignum_lowpower(bignum *);
+void bignum_store(bignum *, limb *, long int, long int);
+void bignum_set_sign(bignum *, int);
+bignum_arena * arena_init(long int);
+void arena_clear(bignum_arena *);
+limb * arena_take(bignum_arena *, long int);
+void arena_give(bignum_arena *, limb *, long int);
+int word_kernels_init(const char *);
+int word_kernels_supported(const word_kernel_set *);
+void word_kernels_print_choices(void);
+limb word_add_n(limb *, const limb *, const limb *, long int);
+limb word_add_n_generic(limb *, const limb *, const limb *, long int);
+limb word_add_n_avx2(limb *, const limb *, const limb *, long int);
+limb word_add_n_avx512(limb *, const limb *, const limb *, long int);
+WORD_INLINE limb word_add_n_loop(limb *, const limb *, const limb *, long int);
+WORD_INLINE limb word_add_n_lookahead(limb *, const limb *, const limb *,
+    long int);
+limb word_add_1(limb *, const limb *, long int, limb);
+limb word_add(limb *, const limb *, long int, const limb *, long int);
+limb word_sub_n(limb *, const limb *, const limb *, long int);
+limb word_sub_n_generic(limb *, const limb *, const limb *, long int);
+limb word_sub_n_avx2(limb *, const limb *, const limb *, long int);
+limb word_sub_n_avx512(limb *, const limb *, const limb *, long int);
+WORD_INLINE limb word_sub_n_loop(limb *, const limb *, const limb *, long int);
+WORD_INLINE limb word_sub_n_lookahead(limb *, const limb *, const limb *,
+    long int);
+limb word_sub_1(limb *, const limb *, long int, limb);
+limb word_sub(limb *, const limb *, long int, const limb *, long int);
+limb word_mul_1(limb *, const limb *, long int, limb);
+limb word_mul_1_generic(limb *, const limb *, long int, limb);
+limb word_mul_1_avx512(limb *, const limb *, long int, limb);
+limb word_addmul_1(limb *, const limb *, long int, limb);
+limb word_addmul_1_generic(limb *, const limb *, long int, limb);
+limb word_addmul_1_avx512(limb *, const limb *, long int, limb);
+limb word_submul_1(limb *, const limb *, long int, limb);
+limb word_submul_1_generic(limb *, const limb *, long int, limb);
+limb word_submul_1_avx2(limb *, const limb *, long int, limb);
+limb word_submul_1_avx512(limb *, const limb *, long int, limb);
+WORD_INLINE limb word_mul_1_loop(limb *, const limb *, long int, limb);
+WORD_INLINE limb word_addmul_1_loop(limb *, const limb *, long int, limb);
+WORD_INLINE limb word_submul_1_loop(limb *, const limb *, long int, limb);
+WORD_INLINE limb word_mul_1_split(limb *, const limb *, long int, limb, int);
+int word_compare(const limb *, const limb *, long int);
+int word_mult(limb *, const limb *, long int, const limb *, long int,
+    bignum_arena *);
+void word_mult_basecase(limb *, const limb *, long int, const limb *, long int);
+int word_square(limb *, const limb *, long int, bignum_arena *);
+void word_square_basecase(limb *, const limb *, long int);
+int word_mult_karatsuba(limb *, const limb *, long int, const limb *, long int,
+    bignum_arena *);
+int word_mult_toom3(limb *, const limb *, long int, const limb *, long int,
+    bignum_arena *);
+limb ntt_power(limb, uint64_t, limb);
+void ntt_transform(limb *, long int, limb, int, limb *);
+int word_mult_ntt(limb *, const limb *, long int, const limb *, long int,
+    bignum_arena *);
+limb word_divide_1(limb *, limb *, long int, limb);
+void word_divide(limb *, limb *, long int, limb *, long int, limb *);
+int word_reciprocal(limb *, limb *, long int, bignum_arena *);
+int word_divide_newton(limb *, limb *, long int, limb *, long int,
+    bignum_arena *);
+void word_mult_benchmark(void);
+void word_divide_benchmark(void);
 
 // Main function
 int main (int argc, char * argv[])
@@ -97,6 +396,51 @@ int main (int argc, char * argv[])
     MPI_Comm_rank(MPI_COMM_WORLD, &threadid);
     MPI_Comm_size(MPI_COMM_WORLD, &total_cores);
     
+    // Running with "bench" in place of the iterations times the different
+    // multiplication and division methods against each other, instead of
+    // calculating pi.
+    // There's no point in every process doing it, so only the first one does.
+    if ((argc > 1) && (strcmp(argv[1], "bench") == 0)) {
+        if (!word_kernels_init((argc > 2) ? argv[2] : 0)) {
+            if (threadid == 0) {
+                printf("Can't use the %s word kernels here\n", argv[2]);
+                word_kernels_print_choices();
+            }
+            MPI_Finalize();
+            return -1;
+        }
+        if (threadid == 0) {
+            printf("Using the %s word kernels\n", word_kernels.name);
+            word_mult_benchmark();
+            word_divide_benchmark();
+        }
+        MPI_Finalize();
+        return 0;
+    }
+    
+    // Running with "romberg" in place of the iterations uses Romberg's method
+    // instead, which has its own arguments
+    if ((argc > 1) && (strcmp(argv[1], "romberg") == 0)) {
+        int result = romberg_main(argc, argv, threadid, total_cores);
+        MPI_Finalize();
+        return result;
+    }
+    
+    // Putting "euler" and an order in front of the usual arguments corrects
+    // the trapezoid rule at its ends instead of using Simpson's Rule (see
+    // fixed_euler_maclaurin)
+    long order = 0L;
+    if ((argc > 1) && (strcmp(argv[1], "euler") == 0)) {
+        if (argc > 2) {
+            order = atol (argv[2]);
+        }
+        if (order < 1L) {
+            order = 8L;
+        }
+        argc = argc - 2;
+        argv = argv + 2;
+    }
+    
     // Obtain command line arguments
     long iterations = 20000L;
     if (argc > 1) {
@@ -105,6 +449,11 @@ int main (int argc, char * argv[])
             iterations = 20000L;
         }
     }
+    // Simpson's Rule works on pairs of steps, so there have to be an even
+    // number of them
+    if (order == 0L) {
+        iterations = iterations + (iterations % 2L);
+    }
     long max_digits = 25L;
     if (argc > 2) {
         max_digits = atoi (argv[2]);
@@ -112,20 +461,37 @@ int main (int argc, char * argv[])
             max_digits = 25L;
         }
     }
+    if (!word_kernels_init((argc > 3) ? argv[3] : 0)) {
+        if (threadid == 0) {
+            printf("Can't use the %s word kernels here\n", argv[3]);
+            word_kernels_print_choices();
+        }
+        MPI_Finalize();
+        return -1;
+    }
     long int lowlimit = (long)threadid * (iterations / (long)total_cores);
     long int highlimit = ((((long)threadid + 1L) == (long)total_cores) ? 
         iterations : (((long)threadid + 1L) * (iterations / (long)total_cores)));
     
+    // Every value in the calculation is between 0 and 4, so it's all done in
+    // fixed point. Each term is truncated in its last place, though, and those
+    // errors add up over all the iterations, so we carry one extra guard digit
+    // for every decimal digit in the number of iterations to absorb them.
+    long work_digits = max_digits;
+    long guard;
+    for (guard = iterations; guard > 0L; guard = guard / 10L) {
+        work_digits++;
+    }
+    
     // Initialize global storage
+    // Fixed numbers don't have a power or significant digits, so the limbs
+    // are all we need to pass around. Figure out how many of them fixed_init
+    // will give each number for our working precision.
     long i, j;
-    long * trappower = (long *)calloc(total_cores, sizeof(long));
-    long * trapsig_digs = (long *)calloc(total_cores, sizeof(long));
-    char * trapdigits = (char *)calloc((total_cores * (int)max_digits), sizeof(char));
-    long * midpower = (long *)calloc(total_cores, sizeof(long));
-    long * midsig_digs = (long *)calloc(total_cores, sizeof(long));
-    char * middigits = (char *)calloc((total_cores * (int)max_digits), sizeof(char));
-    if ((trappower == 0) || (trapsig_digs == 0) || (trapdigits == 0) ||
-        (midpower == 0) || (midsig_digs == 0) || (middigits == 0)) {
+    long max_limbs = ((work_digits + LIMB_DIGITS - 1L) / LIMB_DIGITS) + 2L;
+    limb * trapdigits = (limb *)calloc((total_cores * (int)max_limbs), sizeof(limb));
+    limb * middigits = (limb *)calloc((total_cores * (int)max_limbs), sizeof(limb));
+    if ((trapdigits == 0) || (middigits == 0)) {
         printf("\nError allocating memory for global message passing.\n"); 
         return 1; 
     }
@@ -137,186 +503,138 @@ int main (int argc, char * argv[])
     // So, it may have at most (num_threads - 1) extra iterations. 
     MPI_Barrier(MPI_COMM_WORLD);
     long clock_start = (long)clock();
-    bignum * trap = bignum_init(max_digits);
-    bignum * mid = bignum_init(max_digits);
-    bignum * inverseiterations = bignum_init(max_digits);
-    bignum * temp_holder = bignum_init(max_digits);
-    bignum * temp_holder2 = bignum_init(max_digits);
-    bignum * inc = bignum_init(max_digits);
-    bignum * leftrect = bignum_init(max_digits);
-    bignum * rightrect = bignum_init(max_digits);
-    if (trap == 0 || mid == 0 || inverseiterations == 0 || temp_holder == 0 ||
-        temp_holder2 == 0 || inc == 0 || leftrect == 0 || rightrect == 0) {
+    fixed_sum * trapsum = fixed_sum_init(work_digits);
+    fixed_sum * midsum = fixed_sum_init(work_digits);
+    fixed * trap = fixed_init(work_digits);
+    fixed * mid = fixed_init(work_digits);
+    fixed * inverseiterations = fixed_init(work_digits);
+    fixed * temp_holder = fixed_init(work_digits);
+    bignum_arena * arena = arena_init(work_digits);
+    if (trapsum == 0 || midsum == 0 || trap == 0 || mid == 0 ||
+        inverseiterations == 0 || temp_holder == 0 || arena == 0) {
         printf("\nError allocating memory. Now exiting.\n");
         return -1;
     }
     
+    // All of this process's numbers share one scratch arena, so none of the
+    // arithmetic below has to go back to malloc for its temporary words.
+    trap->arena = arena;
+    mid->arena = arena;
+    inverseiterations->arena = arena;
+    temp_holder->arena = arena;
+    
     // Initialize values of needed variables
-    bignum_set_int(temp_holder, iterations);
-    bignum_int_divide(inverseiterations, 1L, temp_holder);
-    bignum_reset(temp_holder);
-    long k = lowlimit;
-    bignum_divide_int(temp_holder, inverseiterations, 2L);
-    bignum_set_int(inc, k);
-    bignum_mult(temp_holder2, inc, inverseiterations);
-    bignum_reset(inc);
-    bignum_set(inc, temp_holder2);
-    bignum_reset(temp_holder2);
-    bignum_add(temp_holder2, inc, temp_holder);
-    bignum_reset(inc);
-    bignum_set(inc, temp_holder2);
-    bignum_reset(temp_holder2);
-    bignum_reset(temp_holder);
+    fixed_set_int(temp_holder, 1L);
+    fixed_divide_int(inverseiterations, temp_holder, iterations);
+    long start = lowlimit;
+    long end = highlimit;
     
-    // Main iteration loop. Note that the values of inverseiterations, inc, 
-    // mid, and trap are preserved across loop iterations, as is counter k.
-    // inverseiterations is a constant that is stored for simplicity. Man, 
-    // this is looking more and more like assembly...
-    for (i = lowlimit; i < highlimit; i++) {
-        // First, the trapezoid rule is used to estimate pi
-        bignum_reset(leftrect);
-        bignum_set_int(leftrect, k);
-        bignum_mult(temp_holder2, leftrect, inverseiterations);
-        bignum_reset(leftrect);
-        bignum_set(leftrect, temp_holder2);
-        bignum_reset(temp_holder2);
-        k++;
-        bignum_reset(rightrect);
-        bignum_set_int(rightrect, k);
-        bignum_mult(temp_holder2, rightrect, inverseiterations);
-        bignum_reset(rightrect);
-        bignum_set(rightrect, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_add(temp_holder, leftrect, rightrect);
-        bignum_divide_int(temp_holder2, temp_holder, 2L);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_mult(temp_holder2, temp_holder, temp_holder);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_add_int(temp_holder2, temp_holder, 1L);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_int_divide(temp_holder2, 1L, temp_holder);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_mult(temp_holder2, temp_holder, inverseiterations);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_add(temp_holder2, trap, temp_holder);
-        bignum_reset(trap);
-        bignum_set(trap, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_reset(temp_holder);
-        
-        // Next, the midpoint rule is also used to estimate pi
-        bignum_set(temp_holder, inc);
-        bignum_add(temp_holder2, inc, inverseiterations);
-        bignum_reset(inc);
-        bignum_set(inc, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_mult(temp_holder2, temp_holder, temp_holder);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_add_int(temp_holder2, temp_holder, 1L);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_int_divide(temp_holder2, 1L, temp_holder);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_mult(temp_holder2, temp_holder, inverseiterations);
-        bignum_reset(temp_holder);
-        bignum_set(temp_holder, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_add(temp_holder2, mid, temp_holder);
-        bignum_reset(mid);
-        bignum_set(mid, temp_holder2);
-        bignum_reset(temp_holder2);
-        bignum_reset(temp_holder);
+    // The trapezoid rule counts the ends of the integral half as much, and
+    // 1/(1+0^2) is just 1, so the first point is 1/n. With more workers than
+    // steps, several of them start at 0 with nothing to do, so it's only
+    // added by the one that actually has that point.
+    if ((start == 0L) && (start < end)) {
+        fixed_sum_add(trapsum, inverseiterations);
+        start++;
+    }
+    
+    // Simpson's Rule takes the steps two at a time: the even points are the
+    // ends of each pair, which the trapezoid rule uses, and the odd points
+    // are their middles, which the midpoint rule uses. Every point belongs to
+    // exactly one of the two, so each one is only worked out once, and both
+    // rules have a step of 2/n. With x = i/n, each term is then
+    // (2/n) / (1 + x^2) = 2n / (n^2 + i^2), a whole number over a whole
+    // number. When the numbers are long enough, each rule's terms are added up
+    // exactly by binary splitting, with just one division at the end.
+    if ((end > start) && (temp_holder->length >= SERIES_THRESHOLD) &&
+        ((end - start) <= (2L * SERIES_TERMS_PER_LIMB * temp_holder->length))) {
+        long even = start + (start % 2L);
+        long odd = start + 1L - (start % 2L);
+        fixed_ratio_series(temp_holder, 2L * iterations, iterations, even, 2L,
+            (end - even + 1L) / 2L);
+        fixed_sum_add(trapsum, temp_holder);
+        fixed_ratio_series(temp_holder, 2L * iterations, iterations, odd, 2L,
+            (end - odd + 1L) / 2L);
+        fixed_sum_add(midsum, temp_holder);
+        start = end;
+    }
+    
+    // Otherwise, each term is divided out on its own. The denominator just
+    // grows by 2i + 1 from one point to the next, so a term is one division
+    // by a word a few limbs long, with no multiplying at all. Note that the
+    // values of denominator and the sums are preserved across loop
+    // iterations. inverseiterations is a constant that is stored for
+    // simplicity. Every value here stays between 0 and 4, so it's all fixed
+    // point, and the sums are running totals that don't even carry until the
+    // very end.
+    square_sum denominator;
+    square_sum_init(&denominator, iterations, start);
+    for (i = start; i < end; i++) {
+        fixed_ratio(temp_holder, 2L * iterations, denominator.digits,
+            SQUARE_SUM_LIMBS);
+        fixed_sum_add(((i % 2L) == 0L) ? trapsum : midsum, temp_holder);
+        square_sum_next(&denominator);
+    }
+    
+    // The other end of the integral goes to whichever process has the last
+    // iteration. It's also counted half as much, and 1/(1+1^2) is 1/2.
+    if (highlimit == iterations) {
+        fixed_divide_int(temp_holder, inverseiterations, 2L);
+        fixed_sum_add(trapsum, temp_holder);
     }
     
     // Save partial result and clear memory
-    trappower[threadid] = trap->power;
-    trapsig_digs[threadid] = trap->sig_digs;
-    for (i = 0; i < max_digits; i++) {
-        trapdigits[(threadid * max_digits) + i] = trap->digits[i];
-    }
-    midpower[threadid] = mid->power;
-    midsig_digs[threadid] = mid->sig_digs;
-    for (i = 0; i < max_digits; i++) {
-        middigits[(threadid * max_digits) + i] = mid->digits[i];
-    }
-    bignum_clear(inverseiterations);
-    bignum_clear(temp_holder);
-    bignum_clear(temp_holder2);
-    bignum_clear(inc);
-    bignum_clear(leftrect);
-    bignum_clear(rightrect);
+    fixed_sum_get(trap, trapsum);
+    fixed_sum_get(mid, midsum);
+    for (i = 0; i < max_limbs; i++) {
+        trapdigits[(threadid * max_limbs) + i] = trap->digits[i];
+    }
+    for (i = 0; i < max_limbs; i++) {
+        middigits[(threadid * max_limbs) + i] = mid->digits[i];
+    }
+    fixed_sum_clear(trapsum);
+    fixed_sum_clear(midsum);
+    fixed_clear(inverseiterations);
+    fixed_clear(temp_holder);
     
     // Perform an all-gather to get everybody's results. We could just
     // do a regular gather and then have only the main thread perform
     // the final calculation, but why not have everybody do everything?
-    MPI_Allgather(&(trappower[threadid]), 1, MPI_LONG, trappower, 1, MPI_LONG, MPI_COMM_WORLD);
-    MPI_Allgather(&(trapsig_digs[threadid]), 1, MPI_LONG, trapsig_digs, 1, MPI_LONG, MPI_COMM_WORLD);
-    MPI_Allgather(&(trapdigits[threadid * max_digits]), max_digits, MPI_CHAR, trapdigits, max_digits, MPI_CHAR, MPI_COMM_WORLD);
-    MPI_Allgather(&(midpower[threadid]), 1, MPI_LONG, midpower, 1, MPI_LONG, MPI_COMM_WORLD);
-    MPI_Allgather(&(midsig_digs[threadid]), 1, MPI_LONG, midsig_digs, 1, MPI_LONG, MPI_COMM_WORLD);
-    MPI_Allgather(&(middigits[threadid * max_digits]), max_digits, MPI_CHAR, middigits, max_digits, MPI_CHAR, MPI_COMM_WORLD);
+    MPI_Allgather(&(trapdigits[threadid * max_limbs]), max_limbs, MPI_UNSIGNED, trapdigits, max_limbs, MPI_UNSIGNED, MPI_COMM_WORLD);
+    MPI_Allgather(&(middigits[threadid * max_limbs]), max_limbs, MPI_UNSIGNED, middigits, max_limbs, MPI_UNSIGNED, MPI_COMM_WORLD);
     
     // After worker threads end, clean up each of the partial sums
-    bignum_reset(trap);
-    bignum_reset(mid);
-    bignum * temp = bignum_init(max_digits);
-    bignum * simp = bignum_init(max_digits);
-    if (temp == 0 || simp == 0) {
+    fixed_set_int(trap, 0L);
+    fixed_set_int(mid, 0L);
+    fixed * simp = fixed_init(work_digits);
+    if (simp == 0) {
         printf("Error allocating memory. Now exiting.\n");
         return -1;
     }
     for (i = 0L; i < (long)total_cores; i++) {
-        simp->power = trappower[i];
-        simp->sig_digs = trapsig_digs[i];
-        for (j = 0L; j < max_digits; j++) {
-            simp->digits[(int)j] = trapdigits[(int)((i * max_digits) + j)];
-        }
-        bignum_add(temp, trap, simp);
-        bignum_reset(trap);
-        bignum_reset(simp);
-        bignum_set(trap, temp);
-        bignum_reset(temp);
-        simp->power = midpower[i];
-        simp->sig_digs = midsig_digs[i];
-        for (j = 0L; j < max_digits; j++) {
-            simp->digits[(int)j] = middigits[(int)((i * max_digits) + j)];
-        }
-        bignum_add(temp, mid, simp);
-        bignum_reset(mid);
-        bignum_reset(simp);
-        bignum_set(mid, temp);
-        bignum_reset(temp);
-    }
-
-    // Finally, Simpson's Rule is applied
-    bignum_mult_int(temp, mid, 2L);
-    bignum_reset(mid);
-    bignum_set(mid, temp);
-    bignum_reset(temp);
-    bignum_add(temp, trap, mid);
-    bignum_reset(trap);
-    bignum_set(trap, temp);
-    bignum_reset(temp);
-    bignum_divide_int(temp, trap, 3L);
-    bignum_reset(trap);
-    bignum_set(trap, temp);
-    bignum_reset(temp);
-    bignum_mult_int(simp, trap, 4L);
+        for (j = 0L; j < max_limbs; j++) {
+            simp->digits[(int)j] = trapdigits[(int)((i * max_limbs) + j)];
+        }
+        fixed_add(trap, trap, simp);
+        for (j = 0L; j < max_limbs; j++) {
+            simp->digits[(int)j] = middigits[(int)((i * max_limbs) + j)];
+        }
+        fixed_add(mid, mid, simp);
+    }
+
+    // Finally, Simpson's Rule is applied. Or, the trapezoid rule is just the
+    // average of the two sums, and then it gets its end corrections.
+    if (order > 0L) {
+        fixed_add(trap, trap, mid);
+        fixed_divide_int(trap, trap, 2L);
+        fixed_euler_maclaurin(trap, iterations, order);
+    }
+    else {
+        fixed_mult_int(mid, mid, 2L);
+        fixed_add(trap, trap, mid);
+        fixed_divide_int(trap, trap, 3L);
+    }
+    fixed_mult_int(simp, trap, 4L);
     long clock_end = (long)clock();
     if (threadid == 0) {
         char * accepted_pi = "3.14159265358979323846264338327950288419716939937510"
@@ -325,7 +643,7 @@ int main (int argc, char * argv[])
         pi_printer[0] = '0';
         pi_printer[1] = '\0';
         printf("The calculated value of pi is ");
-        bignum_print(simp, 0L);
+        fixed_print(simp, max_digits);
         printf("\nThe actual value of pi is     3.");
         for (i = 0L; i < (((max_digits > 100L) ? 100L : max_digits) - 1L); i++) { 
             // This may print an extra digit or two because, somewhere down in the
@@ -343,40 +661,204 @@ int main (int argc, char * argv[])
     }
         
     // Free global storage
-    free(trappower);
-    free(trapsig_digs);
     free(trapdigits);
-    free(midpower);
-    free(midsig_digs); 
     free(middigits);
-    bignum_clear(trap);
-    bignum_clear(mid);
-    bignum_clear(simp);
-    bignum_clear(temp);
+    fixed_clear(trap);
+    fixed_clear(mid);
+    fixed_clear(simp);
+    arena_clear(arena);
     MPI_Finalize();
     return 0;
 }
 
-// Create space for a bignum with the specified precision.
-// Technically, it's also initialized if we interpret having zero
-// significant digits as the number having a value of zero.
+// Calculates pi with Romberg's method. Level k is the trapezoid rule with
+// 2^k steps, which is just half of level k - 1 plus the new points halfway
+// between the old ones, so every point is only ever worked out once. Each
+// level is then extrapolated together with the ones before it (see
+// romberg_extend). Every process adds up its share of each level's new
+// points, and then, just like main, everybody gathers everybody's results
+// and does the rest. If we're given a file, the first process saves the last
+// row of the table there after every level, so a later run can go deeper
+// without redoing any of them.
+int romberg_main (int argc, char * argv[], int threadid, int total_cores)
+{
+    // Obtain command line arguments
+    long levels = 10L;
+    if (argc > 2) {
+        levels = atol (argv[2]);
+        if ((levels < 1L) || (levels > ROMBERG_MAX_LEVELS)) {
+            levels = 10L;
+        }
+    }
+    long max_digits = 25L;
+    if (argc > 3) {
+        max_digits = atoi (argv[3]);
+        if (max_digits < 1L) {
+            max_digits = 25L;
+        }
+    }
+    char * statefile = ((argc > 4) ? argv[4] : 0);
+    word_kernels_init(0);
+    long work_digits = max_digits + ROMBERG_GUARD_DIGITS;
+    
+    // Initialize storage for the last row of the table, the trapezoid rule
+    // for each new level, and everybody's share of its new points
+    long i, j, k;
+    fixed ** row = (fixed **)calloc((int)(levels + 1L), sizeof(fixed *));
+    fixed * trap = fixed_init(work_digits);
+    fixed * mid = fixed_init(work_digits);
+    fixed * temp_holder = fixed_init(work_digits);
+    bignum_arena * arena = arena_init(work_digits);
+    if (row == 0 || trap == 0 || mid == 0 || temp_holder == 0 || arena == 0) {
+        printf("\nError allocating memory. Now exiting.\n");
+        return -1;
+    }
+    for (k = 0L; k <= levels; k++) {
+        row[(int)k] = fixed_init(work_digits);
+        if (row[(int)k] == 0) {
+            printf("\nError allocating memory. Now exiting.\n");
+            return -1;
+        }
+    }
+    trap->arena = arena;
+    temp_holder->arena = arena;
+    long max_limbs = trap->length;
+    limb * middigits = (limb *)calloc((total_cores * (int)max_limbs), sizeof(limb));
+    if (middigits == 0) {
+        printf("\nError allocating memory for global message passing.\n"); 
+        return 1; 
+    }
+    
+    // Only the first process reads the saved run, if there is one, and it
+    // passes the table along to the rest. Otherwise, everybody starts from
+    // level 0, the trapezoid rule with a single step, which is
+    // (1/(1+0^2) + 1/(1+1^2)) / 2 = 3/4.
+    long level = -1L;
+    if ((statefile != 0) && (threadid == 0)) {
+        level = romberg_load(statefile, row, levels);
+    }
+    MPI_Bcast(&level, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+    if (level == -2L) {
+        if (threadid == 0) {
+            printf("Can't resume from %s: it's damaged, or it was saved with "
+                "different digits or more levels. Now exiting.\n", statefile);
+        }
+        return -1;
+    }
+    if (level < 0L) {
+        fixed_set_int(row[0], 3L);
+        fixed_divide_int(row[0], row[0], 4L);
+        level = 0L;
+    }
+    else {
+        for (k = 0L; k <= level; k++) {
+            MPI_Bcast(row[(int)k]->digits, (int)max_limbs, MPI_UNSIGNED, 0,
+                MPI_COMM_WORLD);
+        }
+        if (threadid == 0) {
+            printf("Resuming from level %ld\n", level);
+        }
+    }
+    
+    // Go down one level at a time. Level k's new points are the odd ones,
+    // i = 1, 3, ..., n - 1 with n = 2^k, each of which is worth
+    // n / (n^2 + i^2), and they're split up between the processes the same
+    // way main splits up the iterations.
+    MPI_Barrier(MPI_COMM_WORLD);
+    long clock_start = (long)clock();
+    for (k = level + 1L; k <= levels; k++) {
+        long n = 1L << k;
+        long points = n / 2L;
+        long lowlimit = (long)threadid * (points / (long)total_cores);
+        long highlimit = ((((long)threadid + 1L) == (long)total_cores) ?
+            points : (((long)threadid + 1L) * (points / (long)total_cores)));
+        fixed_sum * midsum = fixed_sum_init(work_digits);
+        if (midsum == 0) {
+            printf("\nError allocating memory. Now exiting.\n");
+            return -1;
+        }
+        fixed_sum_add_ratios(midsum, temp_holder, n, n, (2L * lowlimit) + 1L,
+            2L, highlimit - lowlimit);
+        fixed_sum_get(mid, midsum);
+        fixed_sum_clear(midsum);
+        for (i = 0; i < max_limbs; i++) {
+            middigits[(threadid * max_limbs) + i] = mid->digits[i];
+        }
+        MPI_Allgather(&(middigits[threadid * max_limbs]), max_limbs, MPI_UNSIGNED, middigits, max_limbs, MPI_UNSIGNED, MPI_COMM_WORLD);
+        
+        // The new trapezoid rule is half the old one, plus the new points
+        fixed_divide_int(trap, row[0], 2L);
+        for (i = 0L; i < (long)total_cores; i++) {
+            for (j = 0L; j < max_limbs; j++) {
+                mid->digits[(int)j] = middigits[(int)((i * max_limbs) + j)];
+            }
+            fixed_add(trap, trap, mid);
+        }
+        romberg_extend(row, k, trap);
+        if ((statefile != 0) && (threadid == 0) &&
+            (romberg_save(statefile, row, k) == 0)) {
+            printf("Error saving to %s. Continuing anyway.\n", statefile);
+        }
+    }
+    
+    // The most extrapolated value is a quarter of pi
+    fixed_mult_int(trap, row[(int)levels], 4L);
+    long clock_end = (long)clock();
+    if (threadid == 0) {
+        char * accepted_pi = "3.14159265358979323846264338327950288419716939937510"
+            "58209749445923078164062862089986280348253421170679";
+        printf("The calculated value of pi is ");
+        fixed_print(trap, max_digits);
+        printf("\nThe actual value of pi is     %.*s", (int)((max_digits < 100L) ?
+            (max_digits + 1L) : 101L), accepted_pi);
+        printf("\nThe time taken to calculate this was %.2f seconds\n", 
+            ((float)(clock_end - clock_start)) / (float)CLOCKS_PER_SEC);
+        printf("The number of levels used was %ld\n", levels);
+        printf("The number of cores used was %d\n", total_cores);
+    }
+    
+    // Free global storage
+    for (k = 0L; k <= levels; k++) {
+        fixed_clear(row[(int)k]);
+    }
+    free(row);
+    free(middigits);
+    fixed_clear(trap);
+    fixed_clear(mid);
+    fixed_clear(temp_holder);
+    arena_clear(arena);
+    return 0;
+}
+
+// Create space for a bignum with the specified precision, which is given in
+// decimal digits. We round that up to whole limbs and then add one more, since
+// the leading limb might only be holding a single digit. Two extra limbs past
+// the precision are also allocated so bignum_add can use the result as its
+// scratchpad, carry and all. Technically, it's also initialized if we
+// interpret having zero significant digits as the number having a value of zero.
 bignum * bignum_init(long int precision) {
     bignum * temp_ptr = (bignum *)calloc(1, sizeof(bignum));
-    temp_ptr->digits = (char *)calloc((int)precision, sizeof(char));
-    if ((temp_ptr->digits) == 0) { temp_ptr = 0; }
-    temp_ptr->precision = precision;
+    if (temp_ptr == 0) { return 0; }
+    temp_ptr->precision = (unsigned long int)(((precision + LIMB_DIGITS - 1L) /
+        LIMB_DIGITS) + 1L);
+    temp_ptr->digits = (limb *)calloc(temp_ptr->precision + 2L, sizeof(limb));
+    if ((temp_ptr->digits) == 0) {
+        free(temp_ptr);
+        temp_ptr = 0;
+    }
     return temp_ptr;
 }
 
-// Resets a bignum's value to zero. memcpy isn't used because 
+// Resets a bignum's value to zero. memcpy isn't used because
 // why bring the string library into this just for this use?
 void bignum_reset(bignum * numval) {
     if ((numval->sig_digs) > 0L) {
-        long int i;
-        for (i = 0L; i < numval->precision; i++) { numval->digits[(int)i] = '\0'; }
+        unsigned long int i;
+        for (i = 0L; i < numval->sig_digs; i++) { numval->digits[i] = 0; }
         numval->power = 0L;
         numval->sig_digs = 0L;
     }
+    numval->negative = 0;
     return;
 }
 
@@ -387,41 +869,123 @@ void bignum_clear(bignum * oldnum) {
     return;
 }
 
-// Set an instance of a bignum to an integer value. Note that if we can't 
-// initialize the temp word we need for copying, we return false (value = 0). 
-// We also assume that the number is non-negative since we only store 
-// unsigned numbers. We assume the result is initialized/reset. Finally, 
-// we handle zero specially by just resetting (again?) the result. Note that
-// we explicitly assume the number to convert fits within the max number of
-// digits. If we try to convert a number bigger than we can store, it won't work.
+// Create a scratch arena for bignums with the specified precision, given in
+// decimal digits just like bignum_init. The word functions underneath take
+// their scratch space from the same arena, so the most we ever need at once
+// is a division done with Newton's method: bignum_divide's own four words,
+// then word_divide_newton's, then an NTT product inside that. Altogether
+// that comes to about 27 words' worth of limbs, so we make room for a few
+// more than that.
+bignum_arena * arena_init(long int precision) {
+    bignum_arena * temp_ptr = (bignum_arena *)calloc(1, sizeof(bignum_arena));
+    if (temp_ptr == 0) { return 0; }
+    long int limbs = ((precision + LIMB_DIGITS - 1L) / LIMB_DIGITS) + 1L;
+    temp_ptr->size = (30L * limbs) + 8L;
+    temp_ptr->space = (limb *)malloc(temp_ptr->size * sizeof(limb));
+    if ((temp_ptr->space) == 0) {
+        free(temp_ptr);
+        temp_ptr = 0;
+    }
+    return temp_ptr;
+}
+
+// Free memory used by an arena when we're done with it
+void arena_clear(bignum_arena * oldarena) {
+    free(oldarena->space);
+    free(oldarena);
+    return;
+}
+
+// Takes a temporary word of the given length out of the arena. If there's
+// no arena, or not enough room left in it, the word comes from malloc
+// instead. Either way, it isn't zeroed, and it returns 0 if we ran out of
+// memory.
+limb * arena_take(bignum_arena * arena, long int length) {
+    if ((arena != 0) && ((arena->used + length) <= arena->size)) {
+        limb * word = arena->space + arena->used;
+        arena->used += length;
+        return word;
+    }
+    return (limb *)malloc(length * sizeof(limb));
+}
+
+// Gives a word from arena_take back. Words have to be given back in the
+// reverse order they were taken, so the one on top of the arena is the only
+// one that can be ours; anything else must have come from malloc.
+void arena_give(bignum_arena * arena, limb * word, long int length) {
+    if ((arena != 0) && (word == (arena->space + arena->used - length))) {
+        arena->used -= length;
+    }
+    else { free(word); }
+    return;
+}
+
+// The power of a bignum's lowest significant limb. Since the limbs are stored
+// least significant first, this is where the number's "ones place" sits.
+long int bignum_lowpower(bignum * numval) {
+    return (numval->power - (long int)(numval->sig_digs) + 1L);
+}
+
+// Stores a raw word of limbs into a bignum, normalizing it on the way in. The
+// word holds wordlen limbs, least significant first, and its lowest limb is
+// worth (10^9)^lowpower. Leading zero limbs are skipped, limbs are truncated
+// off the bottom if there are more than the result's precision, and finally
+// any trailing zero limbs are dropped from the significant digits. Since we
+// only ever copy limbs downwards, the word is allowed to be the result's own
+// digits, which is how bignum_add gets away with using it as a scratchpad.
+void bignum_store(bignum * resultnum, limb * word, long int wordlen,
+    long int lowpower) {
+    long int offset = 0L;
+    long int i;
+    while ((wordlen > 0L) && (word[wordlen - 1L] == 0)) { wordlen--; }
+    if (wordlen == 0L) {
+        resultnum->power = 0L;
+        resultnum->sig_digs = 0L;
+        return;
+    }
+    if (wordlen > (long int)(resultnum->precision)) {
+        offset = wordlen - (long int)(resultnum->precision);
+    }
+    while (word[offset] == 0) { offset++; }
+    resultnum->power = lowpower + wordlen - 1L;
+    resultnum->sig_digs = (unsigned long int)(wordlen - offset);
+    for (i = 0L; i < (wordlen - offset); i++) {
+        resultnum->digits[i] = word[offset + i];
+    }
+    return;
+}
+
+// Sets whether a bignum is negative. bignum_store only deals with the size of
+// a number, so every function that stores a result calls this afterwards, and
+// since zero is never negative, the flag is only set if the number isn't zero.
+void bignum_set_sign(bignum * numval, int negative) {
+    numval->negative = (((numval->sig_digs > 0L) && negative) ? 1 : 0);
+    return;
+}
+
+// Set an instance of a bignum to an integer value, which may be negative.
+// Whatever the result held before is simply overwritten. Finally, we handle
+// zero specially by just resetting the result. Note that we explicitly assume
+// the number to convert fits within the max number of digits. If we try to
+// convert a number bigger than we can store, it gets truncated like any other
+// result.
 int bignum_set_int(bignum * numval, long int intval) {
-    if (intval > 0L) {
-        // Separate out the individual digits (stored backwards)
-        char * temp_word = (char *)calloc((int)(numval->precision), sizeof(char));
-        if (temp_word == 0) { return 0; }
-        long int temp_int = intval;
+    if (intval != 0L) {
+        // Separate out the individual limbs (stored least significant first).
+        // A long never has more than 19 digits, so three limbs always does it.
+        // The size is negated as an unsigned long, so even the most negative
+        // long comes out right.
+        limb temp_word[3];
+        unsigned long int temp_int = ((intval < 0L) ?
+            (0UL - (unsigned long int)intval) : (unsigned long int)intval);
         long int counter = 0L;
         while (temp_int > 0L) {
-            temp_word[(int)counter] = (char)(temp_int % 10L);
-            temp_int = temp_int / 10L;
+            temp_word[counter] = (limb)(temp_int % LIMB_BASE);
+            temp_int = temp_int / LIMB_BASE;
             counter++;
         }
-        
-        // Detect any trailing zeros that we don't need to store
-        numval->power = counter - 1L;
-        long int leadingzeros = 0L;
-        int hasleading = 1;
-        while (hasleading == 1) {
-            if (temp_word[(int)leadingzeros] != 0) { hasleading = 0; }
-            else { leadingzeros++; }
-        }
-        
-        // Store final result into actual bignum variable
-        for (temp_int = 0L; temp_int < (counter - leadingzeros); temp_int++) {
-            numval->digits[(int)temp_int] = temp_word[(int)(counter - temp_int - 1L)];
-        }
-        numval->sig_digs = counter - leadingzeros;
-        free(temp_word);
+        bignum_store(numval, temp_word, counter, 0L);
+        bignum_set_sign(numval, (intval < 0L));
         return 1;
     }
     else { bignum_reset(numval); return 1; }
@@ -430,238 +994,369 @@ int bignum_set_int(bignum * numval, long int intval) {
 // Set an instance of a bignum to the value of another bignum. We don't assume
 // they're both the same precision; just use the precision of the new number.
 // We do assume that the new number has already been initialized, though.
-// strncpy is not used since it quits after seeing the first zero.
 void bignum_set(bignum * newnum, bignum * oldnum) {
     if ((oldnum->sig_digs) > 0L) {
-        newnum->power = oldnum->power;
-        newnum->sig_digs = ((oldnum->sig_digs > newnum->precision) ? 
-            (newnum->precision) : (oldnum->sig_digs));
-        long int i;
-        for (i = 0L; i < newnum->sig_digs; i++) {
-            newnum->digits[(int)i] = oldnum->digits[(int)i];
-        }
+        int negative = oldnum->negative;
+        bignum_store(newnum, oldnum->digits, (long int)(oldnum->sig_digs),
+            bignum_lowpower(oldnum));
+        bignum_set_sign(newnum, negative);
     }
     else { bignum_reset(newnum); }
     return;
 }
 
-// Use printf to print the number one digit at a time. There are a few cases:
+// Prints the number. Each limb holds exactly nine decimal digits, so there's
+// no real base conversion to do: the limbs are just unpacked, one at a time,
+// into a string of digit characters, which also tells us the decimal power
+// and the real number of significant digits. Then the output is laid out in
+// a single buffer and written with one fwrite, rather than a printf for
+// every digit. A negative number just gets a minus sign out front. There are
+// a few cases:
 // power > significant digits: pad end with zeros
 // significant digits > power: fractional digit (non-integer)
 // power is negative: total value less than 1
 // The second argument is the maximum number of significant digits to print.
-// If it's zero, then all available digits will be printed, maxing out at 
+// If it's zero, then all available digits will be printed, maxing out at
 // the precision of the number (the total amount is could possibly store).
-// Note that this is different from total digits printed: zeroes after a 
+// Note that this is different from total digits printed: zeroes after a
 // decimal point but before the first significant digit don't count, and we
-// make sure we print at least the integral part of the number (we only 
+// make sure we print at least the integral part of the number (we only
 // chop off fractional portions).
 void bignum_print(bignum * numval, long int maxdigits) {
-    long int i;
-    long int limit = numval->sig_digs;
-    if (numval->sig_digs == 0L) { printf("0"); } else {
-    if ((maxdigits > 0L) && (maxdigits < numval->sig_digs)) {
-        limit = maxdigits;
+    long int i, j;
+    if (numval->sig_digs == 0L) {
+        fwrite("0", 1, 1, stdout);
+        fflush(stdout);
+        return;
     }
-    if (numval->power < 0L) {
-        printf("0.");
-        for (i = 1L; i < (-1L * (numval->power)); i++) { printf("0"); }
-        for (i = 0L; i < limit; i++) { 
-            printf("%d", (int)(numval->digits[(int)i])); 
+    char * unpacked = (char *)malloc(numval->sig_digs * LIMB_DIGITS);
+    if (unpacked == 0) { return; }
+    long int sig_digs = 0L;
+    for (i = (long int)(numval->sig_digs) - 1L; i >= 0L; i--) {
+        limb value = numval->digits[i];
+        for (j = LIMB_DIGITS - 1L; j >= 0L; j--) {
+            unpacked[sig_digs + j] = (char)('0' + (value % 10));
+            value /= 10;
         }
+        sig_digs += LIMB_DIGITS;
     }
-    else if (numval->sig_digs > (numval->power + 1L)) {
-        for (i = 0L; i <= numval->power; i++) { 
-            printf("%d", (int)(numval->digits[(int)i])); 
-        }
-        if (limit > (numval->power + 1L)) { printf("."); }
-        for (i = (numval->power + 1L); i < limit; i++) { 
-            printf("%d", (int)(numval->digits[(int)i])); 
+    long int leadingzeros = 0L;
+    while (unpacked[leadingzeros] == '0') { leadingzeros++; }
+    while (unpacked[sig_digs - 1L] == '0') { sig_digs--; }
+    char * digits = unpacked + leadingzeros;
+    sig_digs -= leadingzeros;
+    long int power = (numval->power * LIMB_DIGITS) + (LIMB_DIGITS - 1L - leadingzeros);
+    long int limit = sig_digs;
+    if ((maxdigits > 0L) && (maxdigits < sig_digs)) {
+        limit = maxdigits;
+    }
+    long int zeros = 0L;
+    if (power < 0L) { zeros = -1L * power; }
+    else if ((power + 1L) > sig_digs) { zeros = (power + 1L) - sig_digs; }
+    char * output = (char *)malloc(sig_digs + zeros + 3L);
+    if (output == 0) {
+        free(unpacked);
+        return;
+    }
+    long int outlen = 0L;
+    if (numval->negative) { output[outlen++] = '-'; }
+    if (power < 0L) {
+        output[outlen++] = '0';
+        output[outlen++] = '.';
+        for (i = 1L; i < (-1L * power); i++) { output[outlen++] = '0'; }
+        memcpy(output + outlen, digits, limit);
+        outlen += limit;
+    }
+    else if (sig_digs > (power + 1L)) {
+        memcpy(output + outlen, digits, power + 1L);
+        outlen += power + 1L;
+        if (limit > (power + 1L)) {
+            output[outlen++] = '.';
+            memcpy(output + outlen, digits + power + 1L, limit - (power + 1L));
+            outlen += limit - (power + 1L);
         }
     }
-    else { for (i = 0L; i < numval->sig_digs; i++) { 
-        printf("%d", (int)(numval->digits[(int)i])); } 
+    else {
+        memcpy(output + outlen, digits, sig_digs);
+        outlen += sig_digs;
+        for (i = 0L; i < zeros; i++) { output[outlen++] = '0'; }
     }
-    if ((numval->power > 0L) && ((numval->power + 1L) > numval->sig_digs)) { 
-        for (i = 0L; i < ((numval->power + 1L) - numval->sig_digs); i++) { 
-            printf("0"); 
-        } 
-    } }
+    fwrite(output, 1, outlen, stdout);
+    free(output);
+    free(unpacked);
     fflush(stdout);
     return;
 }
 
-// Adds two bignums together and stores the result. Uses the functions to 
-// reset and set the location of the result internally, so current contents of
-// result operand will be overwritten. Like bignum_set_int, returns 1 if 
-// addition was successful or 0 if an error occurred. A special shortcut is
-// taken if either (or both) of the operands are zero. Note that it is possible 
-// for large additions to cause underflow to zero. In that case, special care is
-// taken to make sure the proper input operand is used. Note that we assume the
-// precision of all three operands is the same. If it's not, something terrible
-// like a seg fault or incorrect answer will probably occur. Most importantly, 
-// the result operand CANNOT be the same as one of the input operands, since
-// the result is clobbered immediately and used as a scratchpad. Note that this
-// is also unsigned addition: not only does it not accept negative numbers, it
-// also doesn't do subtraction (which, for that matter, isn't commutative).
+// Adds two bignums together and stores the result. The result operand is used
+// as the scratchpad, so current contents of it will be overwritten. Like
+// bignum_set_int, returns 1 if addition was successful or 0 if an error
+// occurred. A special shortcut is taken if either (or both) of the operands
+// are zero. Note that it is possible for large additions to cause underflow to
+// zero: any limbs of the smaller operand that fall off the end of the result's
+// precision are simply dropped. The result may be the same as either operand
+// (or both), so trap = trap + term is fine: the operand living in the result
+// just gets slid into place inside its own digits before the other one is
+// added on top. Either operand may be negative; when the signs differ, this
+// is really a subtraction, and bignum_add_signed takes care of that.
 int bignum_add(bignum * resultnum, bignum * leftnum, bignum * rightnum) {
-    bignum_reset(resultnum);
-    if ((leftnum->sig_digs == 0L) && (rightnum->sig_digs > 0L)) {
+    return bignum_add_signed(resultnum, leftnum, rightnum, rightnum->negative);
+}
+
+// Subtracts the right bignum from the left one and stores the result. That's
+// just adding the right one with its sign flipped, so everything bignum_add
+// says holds here too, including the result being allowed to be either
+// operand.
+int bignum_sub(bignum * resultnum, bignum * leftnum, bignum * rightnum) {
+    return bignum_add_signed(resultnum, leftnum, rightnum, !(rightnum->negative));
+}
+
+// Does the work for bignum_add and bignum_sub, treating the right operand as
+// negative if rightnegative is set, whatever its own sign is. If the signs
+// match, the sizes are added and the sum keeps that sign. If they don't, the
+// smaller size is subtracted from the bigger one, and the difference takes
+// the bigger one's sign. Either way, it's one pass over the limbs with the
+// carry (or borrow) rippling up, so subtracting costs the same as adding.
+// The difference of two truncated numbers can be one off in its last limb,
+// just like everything else here.
+int bignum_add_signed(bignum * resultnum, bignum * leftnum, bignum * rightnum,
+    int rightnegative) {
+    int leftnegative = leftnum->negative;
+    if ((leftnum->sig_digs == 0L) && (rightnum->sig_digs == 0L)) {
+        bignum_reset(resultnum);
+        return 1;
+    }
+    else if (leftnum->sig_digs == 0L) {
         bignum_set(resultnum, rightnum);
+        bignum_set_sign(resultnum, rightnegative);
         return 1;
     }
-    else if ((rightnum->sig_digs == 0L) && (leftnum->sig_digs > 0L)) {
+    else if (rightnum->sig_digs == 0L) {
         bignum_set(resultnum, leftnum);
         return 1;
     }
-    else if ((leftnum->sig_digs == 0L) && (rightnum->sig_digs == 0L)) { return 1; }
-    else {
-        // First check for overshift:  if the larger number's power is too much
-        // bigger than the smaller number's, the smaller will be completely lost,
-        // and we'll just end up with the large number as the result.
-        if ((((leftnum->power - rightnum->power) > 0) && 
-            ((leftnum->power - rightnum->power) > resultnum->precision))) {
-            bignum_set(resultnum, leftnum);
-            return 1;
+    else if (leftnegative == rightnegative) {
+        // Addition commutes, so if the result is one of the operands, make
+        // sure it's the left one.
+        if (rightnum == resultnum) {
+            rightnum = leftnum;
+            leftnum = resultnum;
         }
-        if ((((rightnum->power - leftnum->power) > 0) && 
-            ((rightnum->power - leftnum->power) > resultnum->precision))) {
-            bignum_set(resultnum, rightnum);
-            return 1;
+
+        // Figure out which limbs the sum covers. It runs from the larger of
+        // the two powers down to the lowest limb of either operand, but no
+        // further than the result's precision allows. One guard limb is kept
+        // past the precision, since a final carry pushes everything up one.
+        long int leftlow = bignum_lowpower(leftnum);
+        long int rightlow = bignum_lowpower(rightnum);
+        long int top = ((leftnum->power > rightnum->power) ?
+            (leftnum->power) : (rightnum->power));
+        long int low = ((leftlow < rightlow) ? leftlow : rightlow);
+        if (low < (top - (long int)(resultnum->precision))) {
+            low = top - (long int)(resultnum->precision);
         }
-        
-        // Next, shift the smaller operand to match the larger one by copying
-        // it into the result operand as a partial sum. Also copy over the 
-        // power and total significant digits into the result.
-        bignum * bigger;
-        bignum * smaller;
-        if ((leftnum->power - rightnum->power) >= 0L) {
-            bigger = leftnum;
-            smaller = rightnum;
+        long int length = top - low + 1L;
+        limb * word = resultnum->digits;
+        long int i;
+
+        // Copy the left operand into place as a partial sum
+        bignum_place(word, length, low, leftnum);
+
+        // Now the main addition: add the right operand on top of it and let
+        // the carry ripple up through the rest of the word. If the right
+        // operand is the result too (so this is x + x), its limbs are the ones
+        // we just moved, which sit exactly where they're about to be added.
+        limb carry = 0;
+        i = ((low > rightlow) ? (low - rightlow) : 0L);
+        if (i < (long int)(rightnum->sig_digs)) {
+            long int offset = rightlow + i - low;
+            long int count = (long int)(rightnum->sig_digs) - i;
+            limb * source = ((rightnum == resultnum) ? (word + offset) :
+                (rightnum->digits + i));
+            carry = word_add_n(word + offset, word + offset, source, count);
+            carry = word_add_1(word + offset + count, word + offset + count,
+                length - offset - count, carry);
         }
-        else {
+        word[length] = carry;
+        bignum_store(resultnum, word, length + 1L, low);
+        bignum_set_sign(resultnum, leftnegative);
+        return 1;
+    }
+    else {
+        // The signs differ, so find which one is bigger. If they're the same
+        // size, they cancel out.
+        int order = bignum_cmp_magnitude(leftnum, rightnum);
+        if (order == 0) {
+            bignum_reset(resultnum);
+            return 1;
+        }
+        bignum * bigger = leftnum;
+        bignum * smaller = rightnum;
+        int negative = leftnegative;
+        if (order < 0) {
             bigger = rightnum;
             smaller = leftnum;
+            negative = rightnegative;
         }
-        long int difference = bigger->power - smaller->power;
-        long int startdigit = smaller->sig_digs + difference;
-        long int transfertotal = smaller->sig_digs;
-        if (startdigit > resultnum->precision) {
-            startdigit = resultnum->precision - difference;
-            transfertotal = startdigit;
+
+        // The difference covers the same limbs a sum would, except that it
+        // can't carry out the top, since the bigger one has the bigger power.
+        long int biglow = bignum_lowpower(bigger);
+        long int smalllow = bignum_lowpower(smaller);
+        long int top = bigger->power;
+        long int low = ((biglow < smalllow) ? biglow : smalllow);
+        if (low < (top - (long int)(resultnum->precision))) {
+            low = top - (long int)(resultnum->precision);
         }
-        long int startdigitcopy = startdigit;
-        startdigit--;
+        long int length = top - low + 1L;
+        limb * word = resultnum->digits;
         long int i;
-        for (i = 0L; i < transfertotal; i++) {
-            if ((startdigit - difference) >= 0L) {
-                resultnum->digits[(int)startdigit] = 
-                    smaller->digits[(int)(startdigit - difference)];
-            }
-            startdigit--;
+
+        // Find the smaller one's limbs that are still inside the result. If
+        // it lives in the result, the bigger one is about to be copied over
+        // it, so those limbs get saved somewhere else first.
+        long int first = ((low > smalllow) ? (low - smalllow) : 0L);
+        long int count = (long int)(smaller->sig_digs) - first;
+        long int offset = smalllow + first - low;
+        limb * source = smaller->digits + first;
+        limb * saved = 0;
+        if ((smaller == resultnum) && (count > 0L)) {
+            saved = arena_take(resultnum->arena, count);
+            if (saved == 0) { return 0; }
+            for (i = 0L; i < count; i++) { saved[i] = source[i]; }
+            source = saved;
         }
-        
-        // Now the main addition loop: loop through each digit and add it.
-        // The carry from the previous digit will add to the current one.
-        // Note that we detect any trailing zeros to take from the sig_digs.
-        // Also, copy over the power and significant digits
-        resultnum->power = bigger->power;
-        resultnum->sig_digs = startdigitcopy;
-        if (bigger->sig_digs > resultnum->sig_digs) {
-            resultnum->sig_digs = bigger->sig_digs;
-            startdigitcopy = resultnum->sig_digs;
-        }
-        int trailingzeros = 1;
-        long int zerocount = 0L;
-        char carry = 0;
-        for (i = 0L; i < resultnum->sig_digs; i++) {
-            resultnum->digits[(int)(startdigitcopy - i - 1L)] += 
-                (bigger->digits[(int)(startdigitcopy - i - 1L)] + carry);
-            if (resultnum->digits[(int)(startdigitcopy - i - 1L)] >= 10) {
-                resultnum->digits[(int)(startdigitcopy - i - 1L)] -= 10;
-                carry = 1;
-            } else { carry = 0; }
-            if (trailingzeros == 1) {
-                if (resultnum->digits[(int)(startdigitcopy - i - 1L)] == '\0') {
-                    zerocount++;
-                } else { trailingzeros = 0; }
-            }
+
+        // Copy the bigger one into place, then subtract the smaller one from
+        // it and let the borrow ripple up. The bigger one really is bigger,
+        // even after truncating both, so nothing borrows out the top.
+        bignum_place(word, length, low, bigger);
+        if (count > 0L) {
+            limb borrow = word_sub_n(word + offset, word + offset, source, count);
+            word_sub_1(word + offset + count, word + offset + count,
+                length - offset - count, borrow);
         }
-        
-        // If we've got trailing zeros, subtract them from the final count of
-        // sig_digs. Also, if we have a carry, we need to shift everything...
-        resultnum->sig_digs -= zerocount;
-        if (carry > 0) {
-            transfertotal = resultnum->sig_digs;
-            if (transfertotal == resultnum->precision) { transfertotal--; }
-            startdigitcopy = transfertotal - 1L;
-            for (i = 0L; i < transfertotal; i++) {
-                if (startdigitcopy >= 0L) {
-                    resultnum->digits[(int)(startdigitcopy + 1L)] =
-                        resultnum->digits[(int)startdigitcopy];
-                }
-                else if ((startdigitcopy + 1L) >= 0L) {
-                    resultnum->digits[(int)(startdigitcopy + 1L)] = 0;
-                }
-                startdigitcopy--;
-            }
-            resultnum->digits[0] = carry;
-            resultnum->power++;
-            resultnum->sig_digs++;
+        if (saved != 0) { arena_give(resultnum->arena, saved, count); }
+        bignum_store(resultnum, word, length, low);
+        bignum_set_sign(resultnum, negative);
+        return 1;
+    }
+}
+
+// Copies a bignum's limbs into a word of the given length whose lowest limb
+// is worth (10^9)^low, for bignum_add_signed to add to or subtract from. Any
+// limbs that would fall off the bottom are skipped, and the rest of the word
+// is zeroed. The bignum may be the one the word belongs to: its limbs are
+// copied from the top down when they move up (and from the bottom up when
+// they move down), so none is overwritten before it's moved.
+void bignum_place(limb * word, long int length, long int low,
+    bignum * numval) {
+    long int i;
+    long int numlow = bignum_lowpower(numval);
+    long int first = ((low > numlow) ? (low - numlow) : 0L);
+    long int count = (long int)(numval->sig_digs) - first;
+    long int offset = numlow + first - low;
+    if (count < 0L) { count = 0L; }
+    if (offset > first) {
+        for (i = count - 1L; i >= 0L; i--) {
+            word[offset + i] = numval->digits[first + i];
         }
-        if (resultnum->sig_digs > resultnum->precision) {
-            resultnum->sig_digs = resultnum->precision;
+    }
+    else {
+        for (i = 0L; i < count; i++) {
+            word[offset + i] = numval->digits[first + i];
         }
-        return 1;
     }
+    for (i = 0L; i < offset; i++) { word[i] = 0; }
+    for (i = offset + count; i < length; i++) { word[i] = 0; }
+    return;
+}
+
+// Compares the sizes of two bignums, ignoring their signs. Returns 1 if the
+// left one is bigger, -1 if the right one is, or 0 if they're the same. Since
+// bignums never have zero limbs at either end, different powers settle it
+// right away; otherwise we walk down from the top limbs until they differ.
+int bignum_cmp_magnitude(bignum * leftnum, bignum * rightnum) {
+    if ((leftnum->sig_digs == 0L) || (rightnum->sig_digs == 0L)) {
+        return ((leftnum->sig_digs > 0L) ? 1 : 0) -
+            ((rightnum->sig_digs > 0L) ? 1 : 0);
+    }
+    if (leftnum->power != rightnum->power) {
+        return ((leftnum->power > rightnum->power) ? 1 : -1);
+    }
+    long int i = (long int)(leftnum->sig_digs) - 1L;
+    long int j = (long int)(rightnum->sig_digs) - 1L;
+    for (; (i >= 0L) && (j >= 0L); i--, j--) {
+        if (leftnum->digits[i] != rightnum->digits[j]) {
+            return ((leftnum->digits[i] > rightnum->digits[j]) ? 1 : -1);
+        }
+    }
+    if (i >= 0L) { return 1; }
+    if (j >= 0L) { return -1; }
+    return 0;
 }
 
-// A convenience wrapper that temporarily creates a new bignum out of the 
-// given integer, calls bignum_add with it and the other operand, and deletes
-// the temporary bignum before exiting. Any problems that bignum_add encounters
-// are passed back up through this function and returned to the caller.
+// Compares two bignums, signs and all. Returns 1 if the left one is bigger,
+// -1 if the right one is, or 0 if they're equal. Zero is never negative, so
+// if the signs differ, that's the whole answer.
+int bignum_cmp(bignum * leftnum, bignum * rightnum) {
+    if (leftnum->negative != rightnum->negative) {
+        return (leftnum->negative ? -1 : 1);
+    }
+    int order = bignum_cmp_magnitude(leftnum, rightnum);
+    return (leftnum->negative ? -order : order);
+}
+
+// A convenience wrapper that temporarily creates a new bignum out of the
+// given integer and calls bignum_add with it and the other operand. Any
+// problems that bignum_add encounters are passed back up through this
+// function and returned to the caller. Since a long never needs more than
+// three limbs, the temporary lives on the stack instead of being allocated
+// at full precision, so the only limbs we touch are the ones in the sum.
 int bignum_add_int(bignum * resultnum, bignum * leftnum, long int rightint) {
-    bignum_reset(resultnum);
     if ((rightint == 0L) && (leftnum->sig_digs > 0L)) {
         bignum_set(resultnum, leftnum);
         return 1;
     }
-    else if ((leftnum->sig_digs == 0L) && (rightint > 0L)) {
+    else if ((leftnum->sig_digs == 0L) && (rightint != 0L)) {
         return bignum_set_int(resultnum, rightint);
     }
-    else if ((leftnum->sig_digs == 0L) && (rightint == 0L)) { return 1; }
+    else if ((leftnum->sig_digs == 0L) && (rightint == 0L)) {
+        bignum_reset(resultnum);
+        return 1;
+    }
     else {
-        bignum * tempnum = bignum_init(resultnum->precision);
-        if (tempnum == 0) { return 0; }
-        if (bignum_set_int(tempnum, rightint) == 0) {
-            bignum_clear(tempnum);
-            return 0;
-        }
-        int retval = bignum_add(resultnum, leftnum, tempnum);
-        bignum_clear(tempnum);
-        return retval;
+        limb temp_word[3];
+        bignum tempnum;
+        tempnum.power = 0L;
+        tempnum.sig_digs = 0L;
+        tempnum.digits = temp_word;
+        tempnum.precision = 3L;
+        tempnum.arena = 0;
+        tempnum.negative = 0;
+        bignum_set_int(&tempnum, rightint);
+        return bignum_add(resultnum, leftnum, &tempnum);
     }
 }
 
-// Multiplies two bignums together and stores the result. Like add, uses 
+// Multiplies two bignums together and stores the result. Like add, uses
 // functions to reset and set the location of the result, and returns 1 upon
 // success or 0 if an error occurred. A special shortcut is taken if either
-// operand is zero, since the result will thus also be zero. Note that we assume
-// the precision of all three operands is the same. If it's not, something 
-// terrible like a seg fault or incorrect answer will probably occur. Most 
-// importantly, the result operand CANNOT be the same as one of the input
-// operands, since the result is clobbered immediately and used as a scratchpad.
-// Also, note that this is unsigned: it assumes both operands are positive.
+// operand is zero, since the result will thus also be zero. The full product
+// is computed into a scratchpad, and then only the top limbs that fit in the
+// result's precision are kept. Since the result isn't touched until the
+// product is done, it may be the same as either operand (or both, for a
+// square). The product is negative if exactly one of the operands is.
 int bignum_mult(bignum * resultnum, bignum * leftnum, bignum * rightnum) {
-    bignum_reset(resultnum);
-    if ((leftnum->sig_digs == 0L) || (rightnum->sig_digs == 0L)) { return 1; }
+    if ((leftnum->sig_digs == 0L) || (rightnum->sig_digs == 0L)) {
+        bignum_reset(resultnum);
+        return 1;
+    }
     else {
-        // Initialize the scratchpad and find the digit limits
-        char * temp_word = (char *)calloc((int)(2L * (resultnum->precision)), sizeof(char));
-        if (temp_word == 0) { return 0; }
+        // Initialize the scratchpad and find the limb counts
         bignum * bigger;
         bignum * smaller;
-        if (((signed long int)(leftnum->sig_digs) - (signed long int)(rightnum->sig_digs)) >= 0L) {
+        if (leftnum->sig_digs >= rightnum->sig_digs) {
             bigger = leftnum;
             smaller = rightnum;
         }
@@ -669,269 +1364,2409 @@ int bignum_mult(bignum * resultnum, bignum * leftnum, bignum * rightnum) {
             bigger = rightnum;
             smaller = leftnum;
         }
-        long int bigstart = (bigger->sig_digs) - 1L;
-        long int smallstart = (smaller->sig_digs) - 1L;
-        long int bigcounter, smallcounter;
-        char carry = 0;
-        
-        // Perform the shift-addition loop. We choose to loop over each
-        // digit of the smaller number for fewer overall iterations. If
-        // the current bigloop has a zero, we can just skip that iteration.
-        // Also, record the final carry, power, and sig_digs values. 
-        for (bigcounter = 0L; bigcounter < (smaller->sig_digs); bigcounter++) {
-            if (smaller->digits[(int)(smallstart - bigcounter)] != '\0') {
-                carry = 0;
-                for(smallcounter = 0L; smallcounter < (bigger->sig_digs); smallcounter++) {
-                    temp_word[(int)((2L * (resultnum->precision)) - smallcounter - 
-                        bigcounter - 1L)] += (carry + (smaller->digits[(int)(smallstart - 
-                        bigcounter)] * bigger->digits[(int)(bigstart - smallcounter)]));
-                    carry = temp_word[(int)((2L * (resultnum->precision)) - 
-                        smallcounter - bigcounter - 1L)] / 10;
-                    temp_word[(int)((2L * (resultnum->precision)) - smallcounter - 
-                        bigcounter - 1L)] %= 10;
-                }
-                temp_word[(int)((2L * (resultnum->precision)) - bigcounter -
-                    (bigger->sig_digs) - 1L)] = carry;
-            }
-        }
-        resultnum->power = ((bigger->power) + (smaller->power));
-        resultnum->sig_digs = ((bigger->sig_digs) + (smaller->sig_digs));
-        
-        // Adjust for lack of a final carry or trailing zeros.
-        if (carry < 1) { 
-            (resultnum->sig_digs)--; 
-            (resultnum->power)--; 
-        }
-        (resultnum->power)++; 
-        int trailingzeros = 1;
-        long int zerocount = 0L;
-        long int i = (2L * (resultnum->precision) - 1L); 
-        while (trailingzeros == 1) {
-            if (temp_word[(int)i] == '\0') {
-                zerocount++;
-            } else { trailingzeros = 0; }
-            i--;
-        }
-        resultnum->sig_digs -= zerocount;
-        if ((resultnum->sig_digs) > (resultnum->precision)) {
-            resultnum->sig_digs = (resultnum->precision);
+        long int biglen = (long int)(bigger->sig_digs);
+        long int smalllen = (long int)(smaller->sig_digs);
+        limb * temp_word = arena_take(resultnum->arena, biglen + smalllen);
+        if (temp_word == 0) { return 0; }
+
+        // Multiply the raw limbs, then let bignum_store sort out the power,
+        // the truncation to our precision, and any trailing zeros.
+        if (word_mult(temp_word, bigger->digits, biglen, smaller->digits,
+            smalllen, resultnum->arena) == 0) {
+            arena_give(resultnum->arena, temp_word, biglen + smalllen);
+            return 0;
         }
-        
-        // Finally, copy from the temp word into the result, taking into 
-        // account any digits we may lose due to precision.
-        long int tempstart = (2L * (resultnum->precision)) - ((bigger->sig_digs) + 
-            (smaller->sig_digs));
-        if (carry < 1) { tempstart++; }
-        for (i = 0L; i < (resultnum->sig_digs); i++) {
-            resultnum->digits[(int)i] = temp_word[(int)(tempstart + i)];
-        }
-        free(temp_word);
+        int negative = (leftnum->negative != rightnum->negative);
+        bignum_store(resultnum, temp_word, biglen + smalllen,
+            bignum_lowpower(bigger) + bignum_lowpower(smaller));
+        bignum_set_sign(resultnum, negative);
+        arena_give(resultnum->arena, temp_word, biglen + smalllen);
+        return 1;
+    }
+}
+
+// Squares a bignum. This is the same as bignum_mult with the operand passed
+// in twice, but it goes through word_square, which only works out each cross
+// product once. The result may be the same as the operand.
+int bignum_square(bignum * resultnum, bignum * numval) {
+    if (numval->sig_digs == 0L) {
+        bignum_reset(resultnum);
         return 1;
     }
+    long int length = (long int)(numval->sig_digs);
+    limb * temp_word = arena_take(resultnum->arena, 2L * length);
+    if (temp_word == 0) { return 0; }
+    if (word_square(temp_word, numval->digits, length,
+        resultnum->arena) == 0) {
+        arena_give(resultnum->arena, temp_word, 2L * length);
+        return 0;
+    }
+    bignum_store(resultnum, temp_word, 2L * length,
+        2L * bignum_lowpower(numval));
+    bignum_set_sign(resultnum, 0);
+    arena_give(resultnum->arena, temp_word, 2L * length);
+    return 1;
 }
 
-// Like bignum_add_int, a convenience wrapper that creates a temporary bignum
-// out of the integer and passes it to bignum_mult. Any problems encountered 
-// in client functions are passed back up to the original caller.
+// Like bignum_add_int, a convenience wrapper that makes a temporary bignum
+// out of the integer on the stack and passes it to bignum_mult. Any problems
+// encountered in client functions are passed back up to the original caller.
+// Small integers (anything that fits in a limb) don't even need that: the
+// product is just one pass of word_mul_1 straight into the result's digits,
+// as long as there's room there for the whole thing before it's truncated.
+// word_mul_1 works in place, so the result may be the same as the operand.
 int bignum_mult_int(bignum * resultnum, bignum * leftnum, long int rightint) {
-    bignum_reset(resultnum);
-    if ((leftnum->sig_digs == 0L) || (rightint == 0L)) { return 1; }
+    if ((leftnum->sig_digs == 0L) || (rightint == 0L)) {
+        bignum_reset(resultnum);
+        return 1;
+    }
+    else if ((rightint > 0L) && (rightint < (long int)LIMB_BASE) &&
+        (leftnum->sig_digs < (resultnum->precision + 2L))) {
+        long int length = (long int)(leftnum->sig_digs);
+        long int lowpower = bignum_lowpower(leftnum);
+        int negative = leftnum->negative;
+        limb * word = resultnum->digits;
+        word[length] = word_mul_1(word, leftnum->digits, length, (limb)rightint);
+        bignum_store(resultnum, word, length + 1L, lowpower);
+        bignum_set_sign(resultnum, negative);
+        return 1;
+    }
     else {
-        bignum * tempnum = bignum_init(resultnum->precision);
-        if (tempnum == 0) { return 0; }
-        if (bignum_set_int(tempnum, rightint) == 0) {
-            bignum_clear(tempnum);
-            return 0;
-        }
-        int retval = bignum_mult(resultnum, leftnum, tempnum);
-        bignum_clear(tempnum);
-        return retval;
+        limb temp_word[3];
+        bignum tempnum;
+        tempnum.power = 0L;
+        tempnum.sig_digs = 0L;
+        tempnum.digits = temp_word;
+        tempnum.precision = 3L;
+        tempnum.arena = 0;
+        tempnum.negative = 0;
+        bignum_set_int(&tempnum, rightint);
+        return bignum_mult(resultnum, leftnum, &tempnum);
     }
 }
 
-// Divides two bignums. Taken in terms of a fraction, leftnum is the numerator 
+// Divides two bignums. Taken in terms of a fraction, leftnum is the numerator
 // and rightnum is the denominator. Performs an explicit check to make sure
-// the denominator is not zero, and returns 0 (an error) if it is. Returns 1 upon 
-// success or 0 if an error occurs. A special shortcut is taken if the numerator is 
-// zero. Note that we assume the precision of all three operands is the same. If it's 
-// not, something terrible like a seg fault or incorrect answer will probably occur. 
-// Most importantly, the result operand CANNOT be the same as one of the input 
-// operands, since the result is clobbered immediately and used as a scratchpad.
-// Also, note that this is unsigned: it assumes both operands are positive.
+// the denominator is not zero, and returns 0 (an error) if it is. Returns 1 upon
+// success or 0 if an error occurs. A special shortcut is taken if the numerator is
+// zero. The numerator's limbs are shifted up far enough that the integer
+// quotient has more limbs than the result can hold, and that quotient is then
+// truncated down to the result's precision. So, like before, we don't round,
+// we truncate, which doesn't minimize error. The quotient is worked out in
+// its own scratchpad and only stored at the very end, so the result may be
+// the same as either operand. The quotient is negative if exactly one of the
+// operands is.
 int bignum_divide(bignum * resultnum, bignum * numerator, bignum * denominator) {
-    bignum_reset(resultnum);
-    if (denominator->sig_digs == 0L) { return 0; }
-    else if (numerator->sig_digs == 0L) { return 1; }
+    if (denominator->sig_digs == 0L) {
+        bignum_reset(resultnum);
+        return 0;
+    }
+    else if (numerator->sig_digs == 0L) {
+        bignum_reset(resultnum);
+        return 1;
+    }
+    int negative = (numerator->negative != denominator->negative);
+    if (denominator->sig_digs == 1L) {
+        bignum_divide_limb(resultnum, numerator->digits,
+            (long int)(numerator->sig_digs), bignum_lowpower(numerator) -
+            bignum_lowpower(denominator), denominator->digits[0]);
+        bignum_set_sign(resultnum, negative);
+        return 1;
+    }
     else {
-        // Initialize the scratchpad and initially copy the numerator into it.
-        // Also initialize the result's power.
-        char * temp_word = (char *)calloc((int)(2L * 
-            (resultnum->precision) + 2L), sizeof(char)); // May only need to be + 1L
+        // Initialize the scratchpad: the shifted numerator (which becomes the
+        // remainder), then the quotient, then room for a multiple of the
+        // denominator. Copy the numerator into the top of its space, with
+        // zeros below it and one zero limb above. The operands don't have to
+        // have the result's precision: if the numerator is already long
+        // enough that its quotient has more limbs than the result can hold,
+        // it isn't shifted at all, and bignum_store just drops the extras.
+        long int numlen = (long int)(numerator->sig_digs);
+        long int denomlen = (long int)(denominator->sig_digs);
+        long int shift = (long int)(resultnum->precision) + denomlen - numlen + 1L;
+        if (shift < 0L) { shift = 0L; }
+        long int wordlen = numlen + shift;
+        long int quotlen = wordlen - denomlen + 1L;
+        long int templen = wordlen + 1L + quotlen + denomlen + 1L;
+        limb * temp_word = arena_take(resultnum->arena, templen);
         if (temp_word == 0) { return 0; }
+        limb * quotient = temp_word + wordlen + 1L;
         long int i;
-        for (i = 0L; i < numerator->sig_digs; i++) {
-            temp_word[(int)(i + 1L)] = numerator->digits[(int)i];
+        for (i = 0L; i < shift; i++) { temp_word[i] = 0; }
+        for (i = 0L; i < numlen; i++) {
+            temp_word[shift + i] = numerator->digits[i];
         }
-        resultnum->power = (numerator->power - denominator->power);
-        long int sigdigctr = 0L;
-        long int numeratorindex = 0L;
-        
-        // First see if we need to "shift" the numerator by comparing it.
-        i = ((denominator->sig_digs) - 1L);
-        int denom_bigger = 1;
-        while ((i >= 0L) && (denom_bigger == 1)) {
-            if ((denominator->digits[(int)((denominator->sig_digs) - i - 1L)]) > 
-                (temp_word[(int)((denominator->sig_digs) - i)])) {
-                i = 0L;
-            }
-            else if ((denominator->digits[(int)((denominator->sig_digs) - 
-                i - 1L)]) < (temp_word[(int)((denominator->sig_digs) - i)])) {
-                denom_bigger = 0;
-            }
-            else if (((denominator->digits[(int)((denominator->sig_digs) - i - 
-                1L)]) == (temp_word[(int)((denominator->sig_digs) - i)])) && (i == 0L)) {
-                denom_bigger = 0;
+        temp_word[wordlen] = 0;
+
+        // Run the division, and store the truncated quotient. Newton's method
+        // only pays off once both the denominator and the quotient are long.
+        if ((denomlen >= NEWTON_THRESHOLD) && (quotlen >= NEWTON_THRESHOLD)) {
+            if (word_divide_newton(quotient, temp_word, wordlen,
+                denominator->digits, denomlen, resultnum->arena) == 0) {
+                arena_give(resultnum->arena, temp_word, templen);
+                return 0;
             }
-            i--;
         }
-        if (denom_bigger == 1) { 
-            numeratorindex++; 
-            (resultnum->power)--;
-        }
-        
-        // Now the main division loop. Note that there's two ways to terminate:
-        // either we've filled the entire precision of the result word and are
-        // forced to truncate our result, or our answer divides exactly. In the
-        // second case, once we've exhausted the numerator's significant digits
-        // and our temp word contains nothing but zeros, we can end early since
-        // all subsequent iterations would contribute only zeros as well. Note
-        // that special care will be taken to detect extra zeros at the end of
-        // the result so that the sig_digs is recorded correctly. Also, we don't
-        // round, we truncate, which doesn't minimize error.
-        int nonzero = 1;
-        while ((sigdigctr < (resultnum->precision)) && (nonzero == 1)) {
-            // First run the subtraction loop.
-            char current_digit = 0;
-            int numer_bigger = 1;
-            while (numer_bigger == 1) {
-                // To subtract, first run a comparison to see if the numerator
-                // is bigger. If it is, increment the counter and subtract. 
-                i = ((denominator->sig_digs) - 1L);
-                denom_bigger = 1;
-                if (temp_word[(int)numeratorindex] > 0) { denom_bigger = 0; }
-                while ((i >= 0L) && (denom_bigger == 1)) {
-                    if ((denominator->digits[(int)((denominator->sig_digs) - 
-                        i - 1L)]) > (temp_word[(int)((denominator->sig_digs) + 
-                        numeratorindex - i)])) {
-                        i = 0L;
-                    }
-                    else if ((denominator->digits[(int)((denominator->sig_digs) - 
-                        i - 1L)]) < (temp_word[(int)((denominator->sig_digs) + 
-                        numeratorindex - i)])) {
-                        denom_bigger = 0;
-                    }
-                    else if (((denominator->digits[(int)((denominator->sig_digs) - 
-                        i - 1L)]) == (temp_word[(int)((denominator->sig_digs) + 
-                        numeratorindex - i)])) && (i == 0L)) {
-                        denom_bigger = 0;
-                    }
-                    i--;
-                }
-                if (denom_bigger == 1) { 
-                    numer_bigger = 0;
-                }
-                
-                // Increment counter and perform subtraction loop.
-                if (numer_bigger == 1) {
-                    current_digit++;
-                    for (i = 0L; i < (denominator->sig_digs); i++) {
-                        temp_word[(int)((denominator->sig_digs) + 
-                            numeratorindex - i)] -= (denominator->digits[
-                            (int)((denominator->sig_digs) - i - 1L)]);
-                        if ((temp_word[(int)((denominator->sig_digs) + 
-                            numeratorindex - i)]) < 0) {
-                            temp_word[(int)((denominator->sig_digs) + 
-                                numeratorindex - i)] += 10L;
-                            (temp_word[(int)((denominator->sig_digs) + 
-                                numeratorindex - i - 1L)]) -= 1L;
-                        }
-                    }
-                }
-            }
-            
-            // If we're past all of the numerator's significant digits, run
-            // zero detection on it to see if we can end early.
-            if (sigdigctr > (numerator->sig_digs)) { // May only need to be >=
-                long int zerocounter = 0L; 
-                i = 0L;
-                while ((i == zerocounter) && (i <= (denominator->sig_digs))) {
-                    if ((temp_word[(int)(numeratorindex + i)]) < 1) { zerocounter++; }
-                    i++;
-                }
-                if (zerocounter == ((denominator->sig_digs) + 1L)) { nonzero = 0; }
-            }
-            
-            // Once we have obtained the proper digit in the result, save it.
-            if (sigdigctr < resultnum->precision) {
-                resultnum->digits[(int)sigdigctr] = current_digit;
-            }
-            sigdigctr++;
-            numeratorindex++;
+        else {
+            word_divide(quotient, temp_word, wordlen, denominator->digits,
+                denomlen, quotient + quotlen);
         }
-        
-        // Record the result's sig digs, taking care to detect trailing zeros.
-        resultnum->sig_digs = sigdigctr;
-        int trailingzeros = 1;
-        long int zerocount = 0L;
-        i = sigdigctr - 1L; 
-        while (trailingzeros == 1) {
-            if (resultnum->digits[(int)i] == '\0') {
-                zerocount++;
-            } else { trailingzeros = 0; }
-            i--;
-        }
-        (resultnum->sig_digs) -= zerocount;
-        free (temp_word);
+        bignum_store(resultnum, quotient, quotlen, bignum_lowpower(numerator) -
+            bignum_lowpower(denominator) - shift);
+        bignum_set_sign(resultnum, negative);
+        arena_give(resultnum->arena, temp_word, templen);
         return 1;
     }
 }
 
-// A convenience wrapper that creates a temporary bignum out of the integer. 
-// Since division is not commutative, two wrappers are given. Any problems 
-// encountered in client functions are passed back up to the original caller.
+// A convenience wrapper that makes a temporary bignum out of the integer on
+// the stack. Since division is not commutative, two wrappers are given. Any
+// problems encountered in client functions are passed back up to the
+// original caller.
+// If the denominator is only a single limb, though, we don't need the
+// temporary at all: the integer's limbs go straight to short division.
 int bignum_int_divide(bignum * resultnum, long int leftint, bignum * rightnum) {
-    bignum_reset(resultnum);
-    if (rightnum->sig_digs == 0L) { return 0; }
-    else if (leftint == 0L) { return 1; }
+    if ((rightnum->sig_digs == 0L) || (leftint == 0L)) {
+        bignum_reset(resultnum);
+        return ((rightnum->sig_digs == 0L) ? 0 : 1);
+    }
+    else if ((rightnum->sig_digs == 1L) && (leftint > 0L)) {
+        limb temp_word[3];
+        unsigned long int temp_int = (unsigned long int)leftint;
+        long int counter = 0L;
+        while (temp_int > 0L) {
+            temp_word[counter] = (limb)(temp_int % LIMB_BASE);
+            temp_int = temp_int / LIMB_BASE;
+            counter++;
+        }
+        int negative = rightnum->negative;
+        bignum_divide_limb(resultnum, temp_word, counter,
+            0L - bignum_lowpower(rightnum), rightnum->digits[0]);
+        bignum_set_sign(resultnum, negative);
+        return 1;
+    }
+    else {
+        limb temp_word[3];
+        bignum tempnum;
+        tempnum.power = 0L;
+        tempnum.sig_digs = 0L;
+        tempnum.digits = temp_word;
+        tempnum.precision = 3L;
+        tempnum.arena = 0;
+        tempnum.negative = 0;
+        bignum_set_int(&tempnum, leftint);
+        return bignum_divide(resultnum, &tempnum, rightnum);
+    }
+}
+
+// A convenience wrapper that makes a temporary bignum out of the integer on
+// the stack. Since division is not commutative, two wrappers are given. Any
+// problems encountered in client functions are passed back up to the
+// original caller.
+// Small divisors (anything that fits in a limb, like the 2s and 3s we use
+// all the time) skip the temporary and just do short division.
+int bignum_divide_int(bignum * resultnum, bignum * leftnum, long int rightint) {
+    if ((rightint == 0L) || (leftnum->sig_digs == 0L)) {
+        bignum_reset(resultnum);
+        return ((rightint == 0L) ? 0 : 1);
+    }
+    else if ((rightint > 0L) && (rightint < (long int)LIMB_BASE)) {
+        int negative = leftnum->negative;
+        bignum_divide_limb(resultnum, leftnum->digits,
+            (long int)(leftnum->sig_digs), bignum_lowpower(leftnum),
+            (limb)rightint);
+        bignum_set_sign(resultnum, negative);
+        return 1;
+    }
+    else {
+        limb temp_word[3];
+        bignum tempnum;
+        tempnum.power = 0L;
+        tempnum.sig_digs = 0L;
+        tempnum.digits = temp_word;
+        tempnum.precision = 3L;
+        tempnum.arena = 0;
+        tempnum.negative = 0;
+        bignum_set_int(&tempnum, rightint);
+        return bignum_divide(resultnum, leftnum, &tempnum);
+    }
+}
+
+// Divides a word by a single limb and stores the quotient, truncated the
+// same way bignum_divide would. The word holds numlen limbs, least significant
+// first, and its lowest limb is worth (10^9)^lowpower. This is just short
+// division, one pass from the top, so it doesn't need any memory of its own:
+// the numerator is shifted up into the result's digits (which have room for
+// precision + 2 limbs), divided in place, and normalized from there. If the
+// numerator is longer than that, its bottom limbs can't change any of the
+// quotient limbs we keep, so they're dropped. Dividing by zero is up to the
+// caller to catch. The word may be the result's own digits: when they move up
+// we copy from the top down, so nothing is overwritten before it's read.
+void bignum_divide_limb(bignum * resultnum, limb * numerator, long int numlen,
+    long int lowpower, limb divisor) {
+    long int i;
+    long int wordlen = (long int)(resultnum->precision) + 2L;
+    long int shift = wordlen - numlen;
+    limb * word = resultnum->digits;
+    if (shift > 0L) {
+        for (i = wordlen - 1L; i >= 0L; i--) {
+            word[i] = ((i >= shift) ? numerator[i - shift] : 0);
+        }
+    }
+    else {
+        for (i = 0L; i < wordlen; i++) { word[i] = numerator[i - shift]; }
+    }
+    word_divide_1(word, word, wordlen, divisor);
+    bignum_store(resultnum, word, wordlen, lowpower - shift);
+    return;
+}
+
+// The fixed-point functions. All the fixed numbers passed to one of these
+// have to be the same length, and every value (including every result) has
+// to stay below 4, or at least below 10^9, since anything that carries out
+// of the whole-number limb is lost. In exchange, adding is one pass of
+// word_add_n, and nothing ever needs normalizing. Like everything else,
+// results are truncated, not rounded. Any of them may be the same as one of
+// their operands.
+
+// Create space for a fixed number with at least the specified number of
+// decimal digits after the point. Like bignum_init, we round up to whole
+// limbs and add one more, and then add the whole-number limb on top. It
+// starts out as zero.
+fixed * fixed_init(long int precision) {
+    fixed * temp_ptr = (fixed *)calloc(1, sizeof(fixed));
+    if (temp_ptr == 0) { return 0; }
+    temp_ptr->length = ((precision + LIMB_DIGITS - 1L) / LIMB_DIGITS) + 2L;
+    temp_ptr->digits = (limb *)calloc(temp_ptr->length, sizeof(limb));
+    if ((temp_ptr->digits) == 0) {
+        free(temp_ptr);
+        temp_ptr = 0;
+    }
+    return temp_ptr;
+}
+
+// Free memory used by a fixed number when we're done with it
+void fixed_clear(fixed * oldnum) {
+    free(oldnum->digits);
+    free(oldnum);
+    return;
+}
+
+// Set a fixed number to a (small, non-negative) integer value
+void fixed_set_int(fixed * numval, long int intval) {
+    long int i;
+    for (i = 0L; i < (numval->length - 1L); i++) { numval->digits[i] = 0; }
+    numval->digits[numval->length - 1L] = (limb)intval;
+    return;
+}
+
+// Set a fixed number to the value of another one
+void fixed_set(fixed * newnum, fixed * oldnum) {
+    long int i;
+    if (newnum != oldnum) {
+        for (i = 0L; i < newnum->length; i++) {
+            newnum->digits[i] = oldnum->digits[i];
+        }
+    }
+    return;
+}
+
+// Prints a fixed number by handing its limbs to a bignum big enough to hold
+// all of them, and letting bignum_print do the work. The second argument is
+// the maximum number of significant digits to print, just like bignum_print.
+void fixed_print(fixed * numval, long int maxdigits) {
+    bignum * printer = bignum_init((numval->length - 1L) * LIMB_DIGITS);
+    if (printer == 0) { return; }
+    bignum_store(printer, numval->digits, numval->length, 1L - numval->length);
+    bignum_print(printer, maxdigits);
+    bignum_clear(printer);
+    return;
+}
+
+// Adds two fixed numbers. Since they line up limb for limb, this is just one
+// carry-propagating pass.
+int fixed_add(fixed * resultnum, fixed * leftnum, fixed * rightnum) {
+    word_add_n(resultnum->digits, leftnum->digits, rightnum->digits,
+        resultnum->length);
+    return 1;
+}
+
+// Subtracts one fixed number from another. The left one can't be smaller
+// than the right one, since a fixed number can't be negative.
+int fixed_sub(fixed * resultnum, fixed * leftnum, fixed * rightnum) {
+    word_sub_n(resultnum->digits, leftnum->digits, rightnum->digits,
+        resultnum->length);
+    return 1;
+}
+
+// Multiplies a fixed number by a non-negative integer. Integers that fit in a
+// limb just take one pass of word_mul_1; bigger ones get split into limbs
+// and go through word_mult. Returns 1 upon success or 0 if we ran out of
+// memory.
+int fixed_mult_int(fixed * resultnum, fixed * leftnum, long int rightint) {
+    long int length = resultnum->length;
+    long int i;
+    if (rightint < (long int)LIMB_BASE) {
+        word_mul_1(resultnum->digits, leftnum->digits, length, (limb)rightint);
+        return 1;
+    }
+    limb int_word[3];
+    unsigned long int temp_int = (unsigned long int)rightint;
+    long int counter = 0L;
+    while (temp_int > 0L) {
+        int_word[counter] = (limb)(temp_int % LIMB_BASE);
+        temp_int = temp_int / LIMB_BASE;
+        counter++;
+    }
+    limb * temp_word = arena_take(resultnum->arena, length + counter);
+    if (temp_word == 0) { return 0; }
+    if (word_mult(temp_word, leftnum->digits, length, int_word, counter,
+        resultnum->arena) == 0) {
+        arena_give(resultnum->arena, temp_word, length + counter);
+        return 0;
+    }
+    for (i = 0L; i < length; i++) { resultnum->digits[i] = temp_word[i]; }
+    arena_give(resultnum->arena, temp_word, length + counter);
+    return 1;
+}
+
+// Divides a fixed number by a positive integer. Integers that fit in a limb
+// take one pass of short division; bigger ones go through fixed_divide_word.
+// Returns 1 upon success or 0 if an error occurs (including dividing by zero).
+int fixed_divide_int(fixed * resultnum, fixed * leftnum, long int rightint) {
+    long int length = resultnum->length;
+    if (rightint <= 0L) { return 0; }
+    if (rightint < (long int)LIMB_BASE) {
+        word_divide_1(resultnum->digits, leftnum->digits, length, (limb)rightint);
+        return 1;
+    }
+    limb int_word[3];
+    unsigned long int temp_int = (unsigned long int)rightint;
+    long int counter = 0L;
+    while (temp_int > 0L) {
+        int_word[counter] = (limb)(temp_int % LIMB_BASE);
+        temp_int = temp_int / LIMB_BASE;
+        counter++;
+    }
+    return fixed_divide_word(resultnum, leftnum, int_word, counter);
+}
+
+// Divides a fixed number by a whole number given as a word, with long
+// division. The word can't be longer than the fixed number, and its top limb
+// can't be zero. Returns 1 upon success or 0 if we ran out of memory.
+int fixed_divide_word(fixed * resultnum, fixed * leftnum, limb * int_word,
+    long int counter) {
+    long int length = resultnum->length;
+    long int i;
+    long int quotlen = length - counter + 1L;
+    long int templen = length + 1L + quotlen + counter + 1L;
+    limb * temp_word = arena_take(resultnum->arena, templen);
+    if (temp_word == 0) { return 0; }
+    limb * quotient = temp_word + length + 1L;
+    for (i = 0L; i < length; i++) { temp_word[i] = leftnum->digits[i]; }
+    temp_word[length] = 0;
+    word_divide(quotient, temp_word, length, int_word, counter,
+        quotient + quotlen);
+    for (i = 0L; i < length; i++) {
+        resultnum->digits[i] = ((i < quotlen) ? quotient[i] : 0);
+    }
+    arena_give(resultnum->arena, temp_word, templen);
+    return 1;
+}
+
+// Create space for a running total of fixed numbers with the given precision
+// (which has to match theirs). It starts out as zero.
+fixed_sum * fixed_sum_init(long int precision) {
+    fixed_sum * temp_ptr = (fixed_sum *)calloc(1, sizeof(fixed_sum));
+    if (temp_ptr == 0) { return 0; }
+    temp_ptr->length = ((precision + LIMB_DIGITS - 1L) / LIMB_DIGITS) + 2L;
+    temp_ptr->digits = (uint64_t *)calloc(temp_ptr->length, sizeof(uint64_t));
+    if ((temp_ptr->digits) == 0) {
+        free(temp_ptr);
+        temp_ptr = 0;
+    }
+    return temp_ptr;
+}
+
+// Free memory used by a running total when we're done with it
+void fixed_sum_clear(fixed_sum * oldsum) {
+    free(oldsum->digits);
+    free(oldsum);
+    return;
+}
+
+// Adds a fixed number into a running total. There's no carrying and no
+// branching in the loop, so the compiler is free to vectorize it.
+void fixed_sum_add(fixed_sum * sum, fixed * addend) {
+    long int i;
+    for (i = 0L; i < sum->length; i++) {
+        sum->digits[i] += addend->digits[i];
+    }
+    sum->count++;
+    if (sum->count >= FIXED_SUM_LIMIT) { fixed_sum_normalize(sum); }
+    return;
+}
+
+// Carries everything over B in each limb of a running total up into the next
+// one, so every limb is back under B. Like fixed_add, anything carrying out
+// of the whole-number limb is lost.
+void fixed_sum_normalize(fixed_sum * sum) {
+    long int i;
+    uint64_t carry = 0;
+    for (i = 0L; i < sum->length; i++) {
+        uint64_t total = sum->digits[i] + carry;
+        sum->digits[i] = total % LIMB_BASE;
+        carry = total / LIMB_BASE;
+    }
+    sum->count = 0L;
+    return;
+}
+
+// Normalizes a running total and stores it in a fixed number
+void fixed_sum_get(fixed * result, fixed_sum * sum) {
+    long int i;
+    fixed_sum_normalize(sum);
+    for (i = 0L; i < result->length; i++) {
+        result->digits[i] = (limb)(sum->digits[i]);
+    }
+    return;
+}
+
+// Sets a fixed number to a whole number divided by a word, which is a whole
+// number in limbs (least significant first). The numerator's limbs just sit
+// above the fractional ones, with nothing but zeros below, so when the word
+// is a single limb this is short division that never has to build the
+// numerator at all. Otherwise, it's word_divide, which for a word of only a
+// limb or three is still a single pass. Either way, it's far cheaper than
+// dividing by a fixed number. Returns 1 on success or 0 if the word is zero,
+// the numerator is negative, or we ran out of memory.
+int fixed_ratio(fixed * resultnum, long int numerator, limb * denominator,
+    long int denomlen) {
+    long int length = resultnum->length;
+    long int i;
+    while ((denomlen > 0L) && (denominator[denomlen - 1L] == 0)) {
+        denomlen--;
+    }
+    if ((denomlen == 0L) || (numerator < 0L)) { return 0; }
+    limb int_word[3];
+    unsigned long int temp_int = (unsigned long int)numerator;
+    long int counter = 0L;
+    while (temp_int > 0L) {
+        int_word[counter] = (limb)(temp_int % LIMB_BASE);
+        temp_int = temp_int / LIMB_BASE;
+        counter++;
+    }
+    if (denomlen == 1L) {
+        // Anything above the whole-number limb is lost, like fixed_add
+        uint64_t divisor = denominator[0];
+        uint64_t remainder = 0;
+        for (i = counter - 1L; i > 0L; i--) {
+            remainder = ((remainder * LIMB_BASE) + int_word[i]) % divisor;
+        }
+        uint64_t current = (remainder * LIMB_BASE) +
+            ((counter > 0L) ? int_word[0] : 0);
+        resultnum->digits[length - 1L] = (limb)(current / divisor);
+        remainder = current % divisor;
+        for (i = length - 2L; i >= 0L; i--) {
+            current = remainder * LIMB_BASE;
+            resultnum->digits[i] = (limb)(current / divisor);
+            remainder = current % divisor;
+        }
+        return 1;
+    }
+    long int numlen = length - 1L + counter;
+    long int quotlen = numlen - denomlen + 1L;
+    if (quotlen < 1L) {
+        for (i = 0L; i < length; i++) { resultnum->digits[i] = 0; }
+        return 1;
+    }
+    long int templen = numlen + 1L + quotlen + denomlen + 1L;
+    limb * temp_word = arena_take(resultnum->arena, templen);
+    if (temp_word == 0) { return 0; }
+    limb * quotient = temp_word + numlen + 1L;
+    for (i = 0L; i < (length - 1L); i++) { temp_word[i] = 0; }
+    for (i = 0L; i < counter; i++) { temp_word[length - 1L + i] = int_word[i]; }
+    temp_word[numlen] = 0;
+    word_divide(quotient, temp_word, numlen, denominator, denomlen,
+        quotient + quotlen);
+    for (i = 0L; i < length; i++) {
+        resultnum->digits[i] = ((i < quotlen) ? quotient[i] : 0);
+    }
+    arena_give(resultnum->arena, temp_word, templen);
+    return 1;
+}
+
+// Sets a fixed number to the quotient of two whole numbers given as words,
+// truncated in its last place. The numerator is shifted up past the
+// fractional limbs, so the quotient comes out lined up, and anything above
+// the whole-number limb is lost, like fixed_add. Long quotients by long
+// denominators use Newton's method, and everything else long division.
+// Returns 1 on success or 0 if the denominator is zero or we ran out of
+// memory.
+int fixed_ratio_words(fixed * resultnum, limb * numerator, long int numlen,
+    limb * denominator, long int denomlen) {
+    long int length = resultnum->length;
+    long int i;
+    while ((numlen > 0L) && (numerator[numlen - 1L] == 0)) { numlen--; }
+    while ((denomlen > 0L) && (denominator[denomlen - 1L] == 0)) {
+        denomlen--;
+    }
+    if (denomlen == 0L) { return 0; }
+    long int shift = length - 1L;
+    long int shiftlen = shift + numlen;
+    long int quotlen = shiftlen - denomlen + 1L;
+    if ((numlen == 0L) || (quotlen < 1L)) {
+        for (i = 0L; i < length; i++) { resultnum->digits[i] = 0; }
+        return 1;
+    }
+    long int templen = (shiftlen + 1L) + quotlen + denomlen + 1L;
+    limb * temp_word = arena_take(resultnum->arena, templen);
+    if (temp_word == 0) { return 0; }
+    limb * quotient = temp_word + shiftlen + 1L;
+    int retval = 1;
+    for (i = 0L; i < shift; i++) { temp_word[i] = 0; }
+    for (i = 0L; i < numlen; i++) { temp_word[shift + i] = numerator[i]; }
+    temp_word[shiftlen] = 0;
+    if ((denomlen >= NEWTON_THRESHOLD) && (quotlen >= NEWTON_THRESHOLD)) {
+        retval = word_divide_newton(quotient, temp_word, shiftlen, denominator,
+            denomlen, resultnum->arena);
+    }
     else {
-        bignum * tempnum = bignum_init(resultnum->precision);
-        if (tempnum == 0) { return 0; }
-        if (bignum_set_int(tempnum, leftint) == 0) {
-            bignum_clear(tempnum);
+        word_divide(quotient, temp_word, shiftlen, denominator, denomlen,
+            quotient + quotlen);
+    }
+    for (i = 0L; i < length; i++) {
+        resultnum->digits[i] = ((i < quotlen) ? quotient[i] : 0);
+    }
+    arena_give(resultnum->arena, temp_word, templen);
+    return retval;
+}
+
+// Sets a square sum to base^2 + index^2. Both have to be under B^3, which
+// any long int is.
+void square_sum_init(square_sum * sum, long int base, long int index) {
+    limb baseword[3];
+    limb indexword[3];
+    limb product[6];
+    long int i;
+    sum->index = index;
+    for (i = 0L; i < 3L; i++) {
+        baseword[i] = (limb)(base % (long int)LIMB_BASE);
+        base = base / (long int)LIMB_BASE;
+        indexword[i] = (limb)(index % (long int)LIMB_BASE);
+        index = index / (long int)LIMB_BASE;
+    }
+    for (i = 0L; i < SQUARE_SUM_LIMBS; i++) { sum->digits[i] = 0; }
+    word_mult_basecase(product, baseword, 3L, baseword, 3L);
+    word_add(sum->digits, sum->digits, SQUARE_SUM_LIMBS, product, 6L);
+    word_mult_basecase(product, indexword, 3L, indexword, 3L);
+    word_add(sum->digits, sum->digits, SQUARE_SUM_LIMBS, product, 6L);
+    return;
+}
+
+// Steps a square sum from base^2 + index^2 to base^2 + (index + 1)^2
+void square_sum_next(square_sum * sum) {
+    unsigned long int step = (2UL * (unsigned long int)sum->index) + 1UL;
+    limb stepword[3];
+    long int i;
+    for (i = 0L; i < 3L; i++) {
+        stepword[i] = (limb)(step % LIMB_BASE);
+        step = step / LIMB_BASE;
+    }
+    word_add(sum->digits, sum->digits, SQUARE_SUM_LIMBS, stepword, 3L);
+    sum->index++;
+    return;
+}
+
+// Sets a fixed number to the sum of numerator / (base^2 + i^2) for count
+// values of i, starting from first and going up by step, with binary
+// splitting: word_series_split adds the terms up exactly as one fraction,
+// P/Q, and then there's just one long division at the end, instead of one
+// division per term. Q grows by a limb or two for every term, though, so
+// this only pays off when the fixed number is long compared to the number of
+// terms (see SERIES_THRESHOLD). Since only the final quotient is truncated,
+// the result is as close as it can be. Returns 1 on success or 0 if we ran
+// out of memory.
+int fixed_ratio_series(fixed * resultnum, long int numerator, long int base,
+    long int first, long int step, long int count) {
+    long int length = resultnum->length;
+    long int i;
+    if ((count <= 0L) || (numerator <= 0L)) {
+        for (i = 0L; i < length; i++) { resultnum->digits[i] = 0; }
+        return (numerator >= 0L);
+    }
+    limb * top;
+    limb * bottom;
+    long int toplen, bottomlen;
+    if (word_series_split(&top, &toplen, &bottom, &bottomlen, base, first,
+        step, count) == 0) {
+        return 0;
+    }
+
+    // Multiply the numerator in, and divide
+    limb int_word[3];
+    unsigned long int temp_int = (unsigned long int)numerator;
+    long int counter = 0L;
+    while (temp_int > 0L) {
+        int_word[counter] = (limb)(temp_int % LIMB_BASE);
+        temp_int = temp_int / LIMB_BASE;
+        counter++;
+    }
+    limb * product = (limb *)malloc((toplen + counter) * sizeof(limb));
+    int retval = (product != 0);
+    if (retval) {
+        word_mult_basecase(product, top, toplen, int_word, counter);
+        retval = fixed_ratio_words(resultnum, product, toplen + counter,
+            bottom, bottomlen);
+    }
+    free(product);
+    free(top);
+    free(bottom);
+    return retval;
+}
+
+// Adds up 1 / (base^2 + i^2) for count values of i, starting from first and
+// going up by step, as one exact fraction. Each half of the terms is added
+// up the same way, and then the two fractions are put together:
+// P/Q = (P1 * Q2 + P2 * Q1) / (Q1 * Q2). The words all come from malloc, and
+// the caller has to free them. Since both halves are the same size, so are
+// the words getting multiplied, which is what Karatsuba, Toom-3, and NTT are
+// best at. Nothing is reduced, so Q is just the product of all the
+// denominators. Returns 1 on success or 0 if we ran out of memory.
+int word_series_split(limb ** numerator, long int * numlen,
+    limb ** denominator, long int * denomlen, long int base, long int first,
+    long int step, long int count) {
+    long int i;
+    if (count == 1L) {
+        square_sum term;
+        square_sum_init(&term, base, first);
+        long int termlen = SQUARE_SUM_LIMBS;
+        while ((termlen > 1L) && (term.digits[termlen - 1L] == 0)) {
+            termlen--;
+        }
+        *numerator = (limb *)malloc(sizeof(limb));
+        *denominator = (limb *)malloc(termlen * sizeof(limb));
+        if ((*numerator == 0) || (*denominator == 0)) {
+            free(*numerator);
+            free(*denominator);
             return 0;
         }
-        int retval = bignum_divide(resultnum, tempnum, rightnum);
-        bignum_clear(tempnum);
-        return retval;
+        (*numerator)[0] = 1;
+        for (i = 0L; i < termlen; i++) { (*denominator)[i] = term.digits[i]; }
+        *numlen = 1L;
+        *denomlen = termlen;
+        return 1;
+    }
+    long int half = count / 2L;
+    limb * lefttop;
+    limb * leftbottom;
+    limb * righttop;
+    limb * rightbottom;
+    long int lefttoplen, leftbottomlen, righttoplen, rightbottomlen;
+    if (word_series_split(&lefttop, &lefttoplen, &leftbottom, &leftbottomlen,
+        base, first, step, half) == 0) {
+        return 0;
+    }
+    if (word_series_split(&righttop, &righttoplen, &rightbottom,
+        &rightbottomlen, base, first + (half * step), step, count - half) == 0) {
+        free(lefttop);
+        free(leftbottom);
+        return 0;
+    }
+    long int toplen = lefttoplen + rightbottomlen;
+    long int crosslen = righttoplen + leftbottomlen;
+    if (crosslen > toplen) { toplen = crosslen; }
+    toplen++;
+    long int bottomlen = leftbottomlen + rightbottomlen;
+    limb * top = (limb *)calloc(toplen, sizeof(limb));
+    limb * bottom = (limb *)malloc(bottomlen * sizeof(limb));
+    limb * cross = (limb *)malloc(crosslen * sizeof(limb));
+    int retval = ((top != 0) && (bottom != 0) && (cross != 0));
+    if (retval) {
+        retval = word_mult(top, lefttop, lefttoplen, rightbottom,
+            rightbottomlen, 0) && word_mult(cross, righttop, righttoplen,
+            leftbottom, leftbottomlen, 0) && word_mult(bottom, leftbottom,
+            leftbottomlen, rightbottom, rightbottomlen, 0);
     }
+    free(lefttop);
+    free(leftbottom);
+    free(righttop);
+    free(rightbottom);
+    if (!retval) {
+        free(top);
+        free(bottom);
+        free(cross);
+        return 0;
+    }
+    word_add(top, top, toplen, cross, crosslen);
+    free(cross);
+    while ((toplen > 1L) && (top[toplen - 1L] == 0)) { toplen--; }
+    while ((bottomlen > 1L) && (bottom[bottomlen - 1L] == 0)) { bottomlen--; }
+    *numerator = top;
+    *numlen = toplen;
+    *denominator = bottom;
+    *denomlen = bottomlen;
+    return 1;
 }
 
-// A convenience wrapper that creates a temporary bignum out of the integer. 
-// Since division is not commutative, two wrappers are given. Any problems 
-// encountered in client functions are passed back up to the original caller.
-int bignum_divide_int(bignum * resultnum, bignum * leftnum, long int rightint) {
-    bignum_reset(resultnum);
-    if (rightint == 0L) { return 0; }
-    else if (leftnum->sig_digs == 0L) { return 1; }
+// Adds numerator / (base^2 + i^2) into a running total for count values of
+// i, starting from first and going up by step. If the fixed number used to
+// hold each result is long enough, they're all added up at once by binary
+// splitting; otherwise, one at a time with fixed_ratio. Returns 1 on success
+// or 0 if we ran out of memory.
+int fixed_sum_add_ratios(fixed_sum * sum, fixed * temp_holder,
+    long int numerator, long int base, long int first, long int step,
+    long int count) {
+    long int i, j;
+    if (count <= 0L) { return 1; }
+    if ((temp_holder->length >= SERIES_THRESHOLD) &&
+        (count <= (SERIES_TERMS_PER_LIMB * temp_holder->length))) {
+        if (fixed_ratio_series(temp_holder, numerator, base, first, step,
+            count) == 0) {
+            return 0;
+        }
+        fixed_sum_add(sum, temp_holder);
+        return 1;
+    }
+    square_sum denominator;
+    square_sum_init(&denominator, base, first);
+    for (i = 0L; i < count; i++) {
+        if (fixed_ratio(temp_holder, numerator, denominator.digits,
+            SQUARE_SUM_LIMBS) == 0) {
+            return 0;
+        }
+        fixed_sum_add(sum, temp_holder);
+        for (j = 0L; j < step; j++) { square_sum_next(&denominator); }
+    }
+    return 1;
+}
+
+// Adds a level to a Romberg table. Going into level k, the row holds
+// R(k-1, 0) through R(k-1, k-1), the trapezoid rule with 2^(k-1) steps and
+// its extrapolations, and trapezoid holds R(k, 0), the trapezoid rule with
+// twice as many steps. Coming out, the row holds R(k, 0) through R(k, k),
+// where each R(k, m) = R(k, m-1) + (R(k, m-1) - R(k-1, m-1)) / (4^m - 1)
+// cancels out the next power of the step in the trapezoid rule's error. A
+// fixed number can't go negative, so the difference is always taken the
+// right way around, and then added or subtracted. The row needs room for
+// k + 1 numbers, all the same length as the trapezoid. Returns 1 on success
+// or 0 if we ran out of memory or went too deep.
+int romberg_extend(fixed ** row, long int level, fixed * trapezoid) {
+    long int m;
+    if ((level < 1L) || (level > ROMBERG_MAX_LEVELS)) { return 0; }
+    fixed * current = fixed_init((trapezoid->length - 2L) * LIMB_DIGITS);
+    fixed * next = fixed_init((trapezoid->length - 2L) * LIMB_DIGITS);
+    fixed * difference = fixed_init((trapezoid->length - 2L) * LIMB_DIGITS);
+    if ((current == 0) || (next == 0) || (difference == 0)) {
+        if (current != 0) { fixed_clear(current); }
+        if (next != 0) { fixed_clear(next); }
+        if (difference != 0) { fixed_clear(difference); }
+        return 0;
+    }
+    difference->arena = trapezoid->arena;
+    fixed_set(current, trapezoid);
+    
+    // 4^m - 1 outgrows a long int past m = 15 where that's only 32 bits, so
+    // it's kept in 64 bits and divided out as a word
+    uint64_t factor = 1U;
+    limb factorword[3];
+    for (m = 1L; m <= level; m++) {
+        factor = factor * 4U;
+        uint64_t temp_int = factor - 1U;
+        long int factorlen = 0L;
+        while (temp_int > 0U) {
+            factorword[factorlen] = (limb)(temp_int % LIMB_BASE);
+            temp_int = temp_int / LIMB_BASE;
+            factorlen++;
+        }
+        if (word_compare(current->digits, row[m - 1L]->digits,
+            current->length) >= 0) {
+            fixed_sub(difference, current, row[m - 1L]);
+            fixed_divide_word(difference, difference, factorword, factorlen);
+            fixed_add(next, current, difference);
+        }
+        else {
+            fixed_sub(difference, row[m - 1L], current);
+            fixed_divide_word(difference, difference, factorword, factorlen);
+            fixed_sub(next, current, difference);
+        }
+        fixed_set(row[m - 1L], current);
+        fixed_set(current, next);
+    }
+    fixed_set(row[level], current);
+    fixed_clear(current);
+    fixed_clear(next);
+    fixed_clear(difference);
+    return 1;
+}
+
+// Saves a Romberg table's last row, R(level, 0) through R(level, level), to
+// a file, so a later run can pick up where this one left off. It's plain
+// text: a line with the level and the length of the numbers, and then a line
+// for each number, with its limbs from the top down. Returns 1 on success or
+// 0 if the file couldn't be written.
+int romberg_save(const char * filename, fixed ** row, long int level) {
+    long int i, m;
+    FILE * state = fopen(filename, "w");
+    if (state == 0) { return 0; }
+    fprintf(state, "romberg %ld %ld\n", level, row[0]->length);
+    for (m = 0L; m <= level; m++) {
+        for (i = row[m]->length - 1L; i >= 0L; i--) {
+            fprintf(state, "%09u%s", (unsigned int)row[m]->digits[i],
+                ((i > 0L) ? " " : "\n"));
+        }
+    }
+    return (fclose(state) == 0);
+}
+
+// Loads a Romberg table's last row saved by romberg_save into the row, which
+// has to have room for at least maxlevel + 1 numbers, all the same length as
+// the ones that were saved. Returns the level it was saved at, -1 if there's
+// no such file, or -2 if it's damaged, saved at a different length, or deeper
+// than maxlevel.
+long int romberg_load(const char * filename, fixed ** row, long int maxlevel) {
+    long int i, m, level, length;
+    unsigned int value;
+    FILE * state = fopen(filename, "r");
+    if (state == 0) { return -1L; }
+    if ((fscanf(state, "romberg %ld %ld", &level, &length) != 2) ||
+        (level < 0L) || (level > maxlevel) || (length != row[0]->length)) {
+        fclose(state);
+        return -2L;
+    }
+    for (m = 0L; m <= level; m++) {
+        for (i = length - 1L; i >= 0L; i--) {
+            if ((fscanf(state, "%u", &value) != 1) || (value >= LIMB_BASE)) {
+                fclose(state);
+                return -2L;
+            }
+            row[m]->digits[i] = (limb)value;
+        }
+    }
+    fclose(state);
+    return level;
+}
+
+// Works out the tangent numbers T_1 through T_count (1, 2, 16, 272, 7936,
+// ...), the whole numbers with tan(x) = sum of T_k x^(2k-1) / (2k-1)!, into
+// count words of length limbs each, one after another. They're built with
+// Brent and Harvey's recurrence, which only ever multiplies positive words by
+// small numbers and adds them, so unlike the usual recurrences for the
+// Bernoulli numbers, nothing cancels and nothing has to be divided. Every
+// T_k is under 4 (2k)!, and the words need room for the last one. The count
+// has to be under LIMB_BASE.
+void word_tangent_numbers(limb * tangent, long int count, long int length) {
+    long int i, j, k;
+    for (i = 0L; i < (count * length); i++) { tangent[i] = 0; }
+    tangent[0] = 1;
+    for (k = 2L; k <= count; k++) {
+        word_mul_1(tangent + ((k - 1L) * length), tangent + ((k - 2L) * length),
+            length, (limb)(k - 1L));
+    }
+    for (k = 2L; k <= count; k++) {
+        for (j = k; j <= count; j++) {
+            limb * current = tangent + ((j - 1L) * length);
+            word_mul_1(current, current, length, (limb)(j - k + 2L));
+            word_addmul_1(current, current - length, length, (limb)(j - k));
+        }
+    }
+    return;
+}
+
+// Adds the Euler-Maclaurin endpoint corrections to a trapezoid rule estimate
+// of the integral of 1/(1+x^2) from 0 to 1 with the given number of panels,
+// using the Bernoulli numbers B_2 through B_(2 order). That takes the error
+// from O(h^2) down to O(h^(2 order + 2)). In general, the correction is
+//     -sum of B_2k h^2k / (2k)! (f^(2k-1)(1) - f^(2k-1)(0)),
+// and for this integrand, every odd derivative is 0 at x = 0, and at x = 1,
+// f^(2k-1)(1) = -(2k-1)! Im(i^k) / 2^k. Writing the Bernoulli numbers in
+// terms of the tangent numbers, B_2k = (-1)^(k-1) 2k T_k / (4^k (4^k - 1)),
+// each term comes out to the exact ratio
+//     T_k / (8^k (4^k - 1) n^2k),
+// which is added when k is one more than a multiple of 4, subtracted when
+// it's three more, and 0 when k is even. The series only converges
+// asymptotically, though: the terms shrink for a while, and then grow without
+// bound. So if they stop shrinking (or drop out of sight altogether) before
+// the order is reached, we stop there. Returns 1 on success or 0 if we ran
+// out of memory.
+int fixed_euler_maclaurin(fixed * trapezoid, long int panels, long int order) {
+    long int i, k;
+    if (panels < 1L) { return 0; }
+    if (order < 1L) { return 1; }
+    if (order >= (long int)LIMB_BASE) { order = (long int)LIMB_BASE - 1L; }
+    
+    // Work out how many limbs everything needs. T_order has fewer digits than
+    // there are digits in all of the numbers from 1 to 2 order put together,
+    // plus one, and 8^k n^2k and 4^k have fewer than order (1 + 2 (digits in
+    // n)) and order digits.
+    long int tangentdigits = 1L;
+    long int paneldigits = 0L;
+    long int temp_int;
+    for (i = 1L; i <= (2L * order); i++) {
+        for (temp_int = i; temp_int > 0L; temp_int = temp_int / 10L) {
+            tangentdigits++;
+        }
+    }
+    for (temp_int = panels; temp_int > 0L; temp_int = temp_int / 10L) {
+        paneldigits++;
+    }
+    long int tangentlen = (tangentdigits / LIMB_DIGITS) + 2L;
+    long int scalelen = ((order * (1L + (2L * paneldigits))) / LIMB_DIGITS) + 2L;
+    long int powerlen = (order / LIMB_DIGITS) + 2L;
+    limb panelword[3];
+    long int panellen = 0L;
+    for (temp_int = panels; temp_int > 0L; temp_int = temp_int / LIMB_BASE) {
+        panelword[panellen] = (limb)(temp_int % LIMB_BASE);
+        panellen++;
+    }
+    
+    // Get the space, and the tangent numbers
+    long int precision = (trapezoid->length - 2L) * LIMB_DIGITS;
+    limb * tangent = (limb *)malloc(order * tangentlen * sizeof(limb));
+    limb * scale = (limb *)calloc(scalelen + 3L, sizeof(limb));
+    limb * product = (limb *)calloc(scalelen + 3L, sizeof(limb));
+    limb * power = (limb *)calloc(powerlen, sizeof(limb));
+    limb * powerless = (limb *)calloc(powerlen, sizeof(limb));
+    limb * denominator = (limb *)calloc(scalelen + powerlen, sizeof(limb));
+    fixed * term = fixed_init(precision);
+    fixed * last = fixed_init(precision);
+    fixed * added = fixed_init(precision);
+    fixed * taken = fixed_init(precision);
+    int retval = ((tangent != 0) && (scale != 0) && (product != 0) &&
+        (power != 0) && (powerless != 0) && (denominator != 0) && (term != 0) &&
+        (last != 0) && (added != 0) && (taken != 0));
+    if (retval) {
+        word_tangent_numbers(tangent, order, tangentlen);
+        scale[0] = 1;
+        power[0] = 1;
+    }
+    
+    // Step 8^k n^2k and 4^k up one k at a time, and work out the terms for
+    // the odd ones
+    for (k = 1L; retval && (k <= order); k++) {
+        word_mul_1(scale, scale, scalelen, 8);
+        for (i = 0L; i < 2L; i++) {
+            word_mult_basecase(product, scale, scalelen, panelword, panellen);
+            memcpy(scale, product, scalelen * sizeof(limb));
+        }
+        word_mul_1(power, power, powerlen, 4);
+        if ((k % 2L) == 0L) { continue; }
+        word_sub_1(powerless, power, powerlen, 1);
+        retval = word_mult(denominator, scale, scalelen, powerless, powerlen,
+            term->arena) &&
+            fixed_ratio_words(term, tangent + ((k - 1L) * tangentlen),
+            tangentlen, denominator, scalelen + powerlen);
+        if (!retval) { break; }
+        for (i = 0L; (i < term->length) && (term->digits[i] == 0); i++) { }
+        if ((i == term->length) || ((k > 1L) &&
+            (word_compare(term->digits, last->digits, term->length) >= 0))) {
+            break;
+        }
+        if ((k % 4L) == 1L) { fixed_add(added, added, term); }
+        else { fixed_add(taken, taken, term); }
+        fixed_set(last, term);
+    }
+    
+    // Each subtracted term is smaller than the added one before it, so this
+    // can't go negative
+    if (retval) {
+        fixed_add(trapezoid, trapezoid, added);
+        fixed_sub(trapezoid, trapezoid, taken);
+    }
+    free(tangent);
+    free(scale);
+    free(product);
+    free(power);
+    free(powerless);
+    free(denominator);
+    if (term != 0) { fixed_clear(term); }
+    if (last != 0) { fixed_clear(last); }
+    if (added != 0) { fixed_clear(added); }
+    if (taken != 0) { fixed_clear(taken); }
+    return retval;
+}
+
+// The rest of these functions work on raw words: arrays of limbs, stored
+// least significant first, with no power or precision attached. They're the
+// actual arithmetic underneath the bignum functions above, which just line
+// the words up and normalize the results. Like the bignum functions, we
+// assume they're given valid lengths and don't check for errors.
+
+// The versions of the word kernels, from the plainest to the fastest, and
+// the one in use. Until word_kernels_init picks another, it's the generic
+// one, which runs anywhere. It's only ever changed before any threads start.
+word_kernel_set word_kernel_sets[3] = {
+    { "generic", word_add_n_generic, word_sub_n_generic, word_mul_1_generic,
+        word_addmul_1_generic, word_submul_1_generic },
+    { "avx2", word_add_n_avx2, word_sub_n_avx2, word_mul_1_generic,
+        word_addmul_1_generic, word_submul_1_avx2 },
+    { "avx512", word_add_n_avx512, word_sub_n_avx512, word_mul_1_avx512,
+        word_addmul_1_avx512, word_submul_1_avx512 }
+};
+word_kernel_set word_kernels = { "generic", word_add_n_generic,
+    word_sub_n_generic, word_mul_1_generic, word_addmul_1_generic,
+    word_submul_1_generic };
+
+// Picks the version of the word kernels to use. Given a name, it uses that
+// one, as long as this processor can run it; given 0, it uses the fastest
+// one this processor can run. Returns 1 on success or 0 if there's no
+// version by that name that this processor can run.
+int word_kernels_init(const char * name) {
+    int i;
+    for (i = 2; i >= 0; i--) {
+        if (((name == 0) || (strcmp(name, word_kernel_sets[i].name) == 0)) &&
+            word_kernels_supported(&word_kernel_sets[i])) {
+            word_kernels = word_kernel_sets[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Checks whether this processor can run a version of the word kernels. With
+// GCC or Clang, that means asking the processor (with cpuid) what it has.
+// Otherwise, each version is just a plain build of the same loops, so the
+// only ones we offer are the ones the whole program was built for.
+int word_kernels_supported(const word_kernel_set * kernels) {
+    if (strcmp(kernels->name, "generic") == 0) { return 1; }
+#if WORD_KERNELS_PER_FUNCTION
+    __builtin_cpu_init();
+    if (strcmp(kernels->name, "avx2") == 0) {
+        return (__builtin_cpu_supports("avx2") != 0);
+    }
+    if (strcmp(kernels->name, "avx512") == 0) {
+        return ((__builtin_cpu_supports("avx512f") != 0) &&
+            (__builtin_cpu_supports("avx512bw") != 0) &&
+            (__builtin_cpu_supports("avx512vl") != 0));
+    }
+#else
+#if defined(__AVX2__)
+    if (strcmp(kernels->name, "avx2") == 0) { return 1; }
+#endif
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+    if (strcmp(kernels->name, "avx512") == 0) { return 1; }
+#endif
+#endif
+    return 0;
+}
+
+// Lists the versions of the word kernels this processor can run, for when
+// the one asked for on the command line isn't one of them.
+void word_kernels_print_choices(void) {
+    int i;
+    printf("Word kernels this machine can use:");
+    for (i = 0; i < 3; i++) {
+        if (word_kernels_supported(&word_kernel_sets[i])) {
+            printf(" %s", word_kernel_sets[i].name);
+        }
+    }
+    printf("\n");
+}
+
+// Adds two words of the same length, returning the final carry. The result
+// may be the same as either operand. This just hands them to whichever
+// version of the word kernels is in use.
+limb word_add_n(limb * result, const limb * left, const limb * right,
+    long int length) {
+    return word_kernels.add_n(result, left, right, length);
+}
+
+// The versions of word_add_n. Without AVX2, carry lookahead only slows us
+// down, so the generic one is just the plain loop.
+limb word_add_n_generic(limb * result, const limb * left, const limb * right,
+    long int length) {
+    return word_add_n_loop(result, left, right, length);
+}
+
+WORD_TARGET_AVX2
+limb word_add_n_avx2(limb * result, const limb * left, const limb * right,
+    long int length) {
+    if (length >= CARRY_LOOKAHEAD_THRESHOLD) {
+        return word_add_n_lookahead(result, left, right, length);
+    }
+    return word_add_n_loop(result, left, right, length);
+}
+
+WORD_TARGET_AVX512
+limb word_add_n_avx512(limb * result, const limb * left, const limb * right,
+    long int length) {
+    if (length >= CARRY_LOOKAHEAD_THRESHOLD) {
+        return word_add_n_lookahead(result, left, right, length);
+    }
+    return word_add_n_loop(result, left, right, length);
+}
+
+// Adds two words of the same length one limb at a time. Each limb is only
+// read once, so the result may be the same as either operand. The carry is
+// worked out with arithmetic instead of a branch, since whether a limb
+// carries is a coin flip the processor can't predict.
+WORD_INLINE limb word_add_n_loop(limb * result, const limb * left,
+    const limb * right, long int length) {
+    long int i;
+    limb carry = 0;
+    for (i = 0L; i < length; i++) {
+        limb sum = left[i] + right[i] + carry;
+        carry = (sum >= LIMB_BASE);
+        result[i] = sum - (carry * LIMB_BASE);
+    }
+    return carry;
+}
+
+// Adds two words of the same length like word_add_n, but 64 limbs at a time
+// with carry lookahead. First, each limb is added without its carry, which
+// gives a sum between 0 and 2B - 2. A sum of at least B generates a carry
+// into the next limb, and a sum of exactly B - 1 passes on any carry that
+// comes into it. With those as two bitmasks, adding the generated carries
+// (shifted up one) to the passing limbs ripples each carry through its run
+// of passing limbs in one 64-bit addition, so the bits that change are
+// exactly the limbs that get a carry in. Then each limb just adds its carry
+// and takes away B if it went over. The result may be the same as either
+// operand.
+WORD_INLINE limb word_add_n_lookahead(limb * result, const limb * left,
+    const limb * right, long int length) {
+    long int block, i;
+    uint64_t carry = 0;
+    for (block = 0L; block < length; block += 64L) {
+        long int blocklen = (((length - block) < 64L) ? (length - block) : 64L);
+        limb * blockresult = result + block;
+        const limb * blockleft = left + block;
+        const limb * blockright = right + block;
+        uint64_t generate = 0;
+        uint64_t propagate = 0;
+        for (i = 0L; i < blocklen; i++) {
+            limb sum = blockleft[i] + blockright[i];
+            blockresult[i] = sum;
+            generate |= (uint64_t)(sum >= LIMB_BASE) << i;
+            propagate |= (uint64_t)(sum == (LIMB_BASE - 1U)) << i;
+        }
+        uint64_t rippled = ((generate << 1) | carry) + propagate;
+        uint64_t carries = rippled ^ propagate;
+        if (blocklen == 64L) {
+            carry = (generate >> 63) | (uint64_t)(rippled < propagate);
+        }
+        else { carry = (carries >> blocklen) & 1U; }
+        for (i = 0L; i < blocklen; i++) {
+            limb sum = blockresult[i] + (limb)((carries >> i) & 1U);
+            blockresult[i] = sum - ((sum >= LIMB_BASE) ? LIMB_BASE : 0U);
+        }
+    }
+    return (limb)carry;
+}
+
+// Adds a single limb to a word, rippling the carry as far as it needs to go,
+// and returns the final carry. The result may be the same as the operand, in
+// which case we can stop as soon as there's nothing left to carry.
+limb word_add_1(limb * result, const limb * left, long int length, limb right) {
+    long int i;
+    for (i = 0L; i < length; i++) {
+        if ((right == 0) && (result == left)) { return 0; }
+        limb sum = left[i] + right;
+        if (sum >= LIMB_BASE) {
+            result[i] = sum - LIMB_BASE;
+            right = 1;
+        } else {
+            result[i] = sum;
+            right = 0;
+        }
+    }
+    return right;
+}
+
+// Adds two words of different lengths, returning the final carry. The left
+// word has to be the longer one. The result may be the same as either operand.
+limb word_add(limb * result, const limb * left, long int leftlen,
+    const limb * right, long int rightlen) {
+    limb carry = word_add_n(result, left, right, rightlen);
+    return word_add_1(result + rightlen, left + rightlen, leftlen - rightlen,
+        carry);
+}
+
+// Subtracts the right word from the left word, both of the same length, and
+// returns the final borrow. The result may be the same as either operand.
+// Like word_add_n, this goes to whichever version of the word kernels is in
+// use.
+limb word_sub_n(limb * result, const limb * left, const limb * right,
+    long int length) {
+    return word_kernels.sub_n(result, left, right, length);
+}
+
+// The versions of word_sub_n, which are picked the same way as word_add_n's
+limb word_sub_n_generic(limb * result, const limb * left, const limb * right,
+    long int length) {
+    return word_sub_n_loop(result, left, right, length);
+}
+
+WORD_TARGET_AVX2
+limb word_sub_n_avx2(limb * result, const limb * left, const limb * right,
+    long int length) {
+    if (length >= CARRY_LOOKAHEAD_THRESHOLD) {
+        return word_sub_n_lookahead(result, left, right, length);
+    }
+    return word_sub_n_loop(result, left, right, length);
+}
+
+WORD_TARGET_AVX512
+limb word_sub_n_avx512(limb * result, const limb * left, const limb * right,
+    long int length) {
+    if (length >= CARRY_LOOKAHEAD_THRESHOLD) {
+        return word_sub_n_lookahead(result, left, right, length);
+    }
+    return word_sub_n_loop(result, left, right, length);
+}
+
+// Subtracts one word from another one limb at a time. Like word_add_n_loop,
+// the borrow is worked out without a branch.
+WORD_INLINE limb word_sub_n_loop(limb * result, const limb * left,
+    const limb * right, long int length) {
+    long int i;
+    limb borrow = 0;
+    for (i = 0L; i < length; i++) {
+        limb subtrahend = right[i] + borrow;
+        borrow = (left[i] < subtrahend);
+        result[i] = left[i] + (borrow * LIMB_BASE) - subtrahend;
+    }
+    return borrow;
+}
+
+// Subtracts one word from another like word_sub_n, but with the same carry
+// lookahead as word_add_n_lookahead. A limb generates a borrow if it's
+// smaller than the one being taken from it, and passes one on if they're
+// equal (since taking the borrow from the zero difference goes negative).
+// The result may be the same as either operand.
+WORD_INLINE limb word_sub_n_lookahead(limb * result, const limb * left,
+    const limb * right, long int length) {
+    long int block, i;
+    uint64_t borrow = 0;
+    for (block = 0L; block < length; block += 64L) {
+        long int blocklen = (((length - block) < 64L) ? (length - block) : 64L);
+        limb * blockresult = result + block;
+        const limb * blockleft = left + block;
+        const limb * blockright = right + block;
+        uint64_t generate = 0;
+        uint64_t propagate = 0;
+        for (i = 0L; i < blocklen; i++) {
+            limb difference = blockleft[i] - blockright[i];
+            generate |= (uint64_t)(blockleft[i] < blockright[i]) << i;
+            propagate |= (uint64_t)(difference == 0) << i;
+            blockresult[i] = difference +
+                ((blockleft[i] < blockright[i]) ? LIMB_BASE : 0U);
+        }
+        uint64_t rippled = ((generate << 1) | borrow) + propagate;
+        uint64_t borrows = rippled ^ propagate;
+        if (blocklen == 64L) {
+            borrow = (generate >> 63) | (uint64_t)(rippled < propagate);
+        }
+        else { borrow = (borrows >> blocklen) & 1U; }
+        for (i = 0L; i < blocklen; i++) {
+            limb difference = blockresult[i] - (limb)((borrows >> i) & 1U);
+            blockresult[i] = difference +
+                ((difference >= LIMB_BASE) ? LIMB_BASE : 0U);
+        }
+    }
+    return (limb)borrow;
+}
+
+// Subtracts a single limb from a word, rippling the borrow as far as it needs
+// to go, and returns the final borrow. Like word_add_1, we can stop early if
+// we're working in place and there's nothing left to borrow.
+limb word_sub_1(limb * result, const limb * left, long int length, limb right) {
+    long int i;
+    for (i = 0L; i < length; i++) {
+        if ((right == 0) && (result == left)) { return 0; }
+        if (left[i] < right) {
+            result[i] = left[i] + LIMB_BASE - right;
+            right = 1;
+        } else {
+            result[i] = left[i] - right;
+            right = 0;
+        }
+    }
+    return right;
+}
+
+// Subtracts a shorter word from a longer one, returning the final borrow.
+// The result may be the same as either operand.
+limb word_sub(limb * result, const limb * left, long int leftlen,
+    const limb * right, long int rightlen) {
+    limb borrow = word_sub_n(result, left, right, rightlen);
+    return word_sub_1(result + rightlen, left + rightlen, leftlen - rightlen,
+        borrow);
+}
+
+// Multiplies a word by a single limb and returns the limb that carried out
+// of the top. The result may be the same as the operand. Like word_add_n,
+// this goes to whichever version of the word kernels is in use, and so do
+// word_addmul_1 and word_submul_1.
+limb word_mul_1(limb * result, const limb * left, long int length, limb right) {
+    return word_kernels.mul_1(result, left, length, right);
+}
+
+// Multiplies a word by a single limb and adds the product into the result,
+// returning the limb that carried out of the top.
+limb word_addmul_1(limb * result, const limb * left, long int length,
+    limb right) {
+    return word_kernels.addmul_1(result, left, length, right);
+}
+
+// Multiplies a word by a single limb and subtracts the product from the
+// result, returning the amount that needs to be borrowed from above the top.
+limb word_submul_1(limb * result, const limb * left, long int length,
+    limb right) {
+    return word_kernels.submul_1(result, left, length, right);
+}
+
+// The versions of word_mul_1, word_addmul_1, and word_submul_1. The generic
+// ones are just the plain loops, and the others split the products up once
+// the words are long enough. The AVX2 kernels use the generic word_mul_1 and
+// word_addmul_1 (see MULTIPLY_SPLIT_THRESHOLD).
+limb word_mul_1_generic(limb * result, const limb * left, long int length,
+    limb right) {
+    return word_mul_1_loop(result, left, length, right);
+}
+
+WORD_TARGET_AVX512
+limb word_mul_1_avx512(limb * result, const limb * left, long int length,
+    limb right) {
+    if (length >= MULTIPLY_SPLIT_THRESHOLD) {
+        return word_mul_1_split(result, left, length, right, 0);
+    }
+    return word_mul_1_loop(result, left, length, right);
+}
+
+limb word_addmul_1_generic(limb * result, const limb * left, long int length,
+    limb right) {
+    return word_addmul_1_loop(result, left, length, right);
+}
+
+WORD_TARGET_AVX512
+limb word_addmul_1_avx512(limb * result, const limb * left, long int length,
+    limb right) {
+    if (length >= MULTIPLY_SPLIT_THRESHOLD) {
+        return word_mul_1_split(result, left, length, right, 1);
+    }
+    return word_addmul_1_loop(result, left, length, right);
+}
+
+limb word_submul_1_generic(limb * result, const limb * left, long int length,
+    limb right) {
+    return word_submul_1_loop(result, left, length, right);
+}
+
+WORD_TARGET_AVX2
+limb word_submul_1_avx2(limb * result, const limb * left, long int length,
+    limb right) {
+    if (length >= MULTIPLY_SPLIT_THRESHOLD) {
+        return word_mul_1_split(result, left, length, right, -1);
+    }
+    return word_submul_1_loop(result, left, length, right);
+}
+
+WORD_TARGET_AVX512
+limb word_submul_1_avx512(limb * result, const limb * left, long int length,
+    limb right) {
+    if (length >= MULTIPLY_SPLIT_THRESHOLD) {
+        return word_mul_1_split(result, left, length, right, -1);
+    }
+    return word_submul_1_loop(result, left, length, right);
+}
+
+// Multiplies a word by a single limb one limb at a time, carrying each
+// product's high half into the next. The result may be the same as the
+// operand.
+WORD_INLINE limb word_mul_1_loop(limb * result, const limb * left,
+    long int length, limb right) {
+    long int i;
+    uint64_t carry = 0;
+    for (i = 0L; i < length; i++) {
+        uint64_t product = ((uint64_t)left[i] * right) + carry;
+        result[i] = (limb)(product % LIMB_BASE);
+        carry = product / LIMB_BASE;
+    }
+    return (limb)carry;
+}
+
+// Multiplies and adds one limb at a time. Even in the worst case,
+// limb * limb + limb + carry still fits in 64 bits.
+WORD_INLINE limb word_addmul_1_loop(limb * result, const limb * left,
+    long int length, limb right) {
+    long int i;
+    uint64_t carry = 0;
+    for (i = 0L; i < length; i++) {
+        uint64_t product = ((uint64_t)left[i] * right) + result[i] + carry;
+        result[i] = (limb)(product % LIMB_BASE);
+        carry = product / LIMB_BASE;
+    }
+    return (limb)carry;
+}
+
+// Multiplies and subtracts one limb at a time
+WORD_INLINE limb word_submul_1_loop(limb * result, const limb * left,
+    long int length, limb right) {
+    long int i;
+    uint64_t carry = 0;
+    for (i = 0L; i < length; i++) {
+        uint64_t product = ((uint64_t)left[i] * right) + carry;
+        limb low = (limb)(product % LIMB_BASE);
+        carry = product / LIMB_BASE;
+        if (result[i] < low) {
+            result[i] = result[i] + LIMB_BASE - low;
+            carry++;
+        } else { result[i] -= low; }
+    }
+    return (limb)carry;
+}
+
+// Multiplies a word by a single limb 64 limbs at a time, and then stores the
+// product in the result (if accumulate is 0), adds it in (if it's 1), or
+// subtracts it (if it's -1), returning what carries out of the top or needs
+// to be borrowed from above it. The plain loops can't start on a limb until
+// the division by B for the one before it is done. Here, every limb product
+// is split into its low and high halves on its own: the quotient is guessed
+// in floating point, which is never off by more than one since it's under
+// B, and then the remainder, worked out in 32 bits, says which way to fix
+// it. That remainder is between -B and 2B, which 32 bits can still tell
+// apart, since everything from 3B up can only be a negative one that
+// wrapped around. Then each limb of the result gets its own low half and
+// the limb below's high half, which comes to less than 3B, so it carries
+// 0, 1, or 2 on to the next limb. Adding those in leaves each limb at most
+// B + 1, and what little carrying is left is done with the same lookahead
+// as word_add_n_lookahead. Subtracting works the same way, with everything
+// turned around into borrows. Every pass but the lookahead itself is
+// independent limb by limb, so the compiler can vectorize them. The result
+// may be the same as the operand.
+WORD_INLINE limb word_mul_1_split(limb * result, const limb * left,
+    long int length, limb right, int accumulate) {
+    long int block, i;
+    limb low[64];
+    limb high[64];
+    limb digit[64];
+    limb over[64];
+    double scale = (double)right / (double)LIMB_BASE;
+    limb lasthigh = 0;
+    limb lastover = 0;
+    uint64_t carry = 0;
+    for (block = 0L; block < length; block += 64L) {
+        long int blocklen = (((length - block) < 64L) ? (length - block) : 64L);
+        limb * blockresult = result + block;
+        const limb * blockleft = left + block;
+        for (i = 0L; i < blocklen; i++) {
+            limb guess = (limb)(int32_t)((double)(int32_t)blockleft[i] * scale);
+            limb remainder = (blockleft[i] * right) - (guess * LIMB_BASE);
+            limb under = (remainder >= (3U * LIMB_BASE));
+            limb past = (remainder >= LIMB_BASE) & (under ^ 1U);
+            low[i] = remainder + (under * LIMB_BASE) - (past * LIMB_BASE);
+            high[i] = guess - under + past;
+        }
+        for (i = 0L; i < blocklen; i++) {
+            limb below = ((i == 0L) ? lasthigh : high[i - 1L]);
+            limb sum;
+            if (accumulate < 0) {
+                sum = (blockresult[i] + (2U * LIMB_BASE)) - low[i] - below;
+            }
+            else {
+                sum = ((accumulate > 0) ? blockresult[i] : 0U) + low[i] + below;
+            }
+            limb carried = (sum >= LIMB_BASE) + (sum >= (2U * LIMB_BASE));
+            digit[i] = sum - (carried * LIMB_BASE);
+            over[i] = ((accumulate < 0) ? (2U - carried) : carried);
+        }
+        uint64_t generate = 0;
+        uint64_t propagate = 0;
+        for (i = 0L; i < blocklen; i++) {
+            limb below = ((i == 0L) ? lastover : over[i - 1L]);
+            if (accumulate < 0) {
+                limb difference = digit[i] - below;
+                generate |= (uint64_t)(digit[i] < below) << i;
+                propagate |= (uint64_t)(difference == 0) << i;
+                digit[i] = difference + ((digit[i] < below) ? LIMB_BASE : 0U);
+            }
+            else {
+                limb sum = digit[i] + below;
+                generate |= (uint64_t)(sum >= LIMB_BASE) << i;
+                propagate |= (uint64_t)(sum == (LIMB_BASE - 1U)) << i;
+                digit[i] = sum - ((sum >= LIMB_BASE) ? LIMB_BASE : 0U);
+            }
+        }
+        uint64_t rippled = ((generate << 1) | carry) + propagate;
+        uint64_t carries = rippled ^ propagate;
+        if (blocklen == 64L) {
+            carry = (generate >> 63) | (uint64_t)(rippled < propagate);
+        }
+        else { carry = (carries >> blocklen) & 1U; }
+        for (i = 0L; i < blocklen; i++) {
+            limb bit = (limb)((carries >> i) & 1U);
+            if (accumulate < 0) {
+                limb difference = digit[i] - bit;
+                blockresult[i] = difference +
+                    ((difference >= LIMB_BASE) ? LIMB_BASE : 0U);
+            }
+            else {
+                limb sum = digit[i] + bit;
+                blockresult[i] = sum - ((sum >= LIMB_BASE) ? LIMB_BASE : 0U);
+            }
+        }
+        lasthigh = high[blocklen - 1L];
+        lastover = over[blocklen - 1L];
+    }
+    return lasthigh + lastover + (limb)carry;
+}
+
+// Compares two words of the same length, starting from the top. Returns a
+// positive number if the left is bigger, negative if the right is bigger,
+// or zero if they're equal.
+int word_compare(const limb * left, const limb * right, long int length) {
+    long int i;
+    for (i = length - 1L; i >= 0L; i--) {
+        if (left[i] != right[i]) { return ((left[i] > right[i]) ? 1 : -1); }
+    }
+    return 0;
+}
+
+// Multiplies two words, picking the fastest method for their size: the
+// schoolbook method for short words, Karatsuba once the shorter word reaches
+// KARATSUBA_THRESHOLD limbs, Toom-3 once it reaches TOOM3_THRESHOLD limbs, and
+// NTT once it reaches NTT_THRESHOLD limbs (as long as the product isn't too
+// long for the NTT primes). If one word is much longer than the other, the
+// longer one is chopped into pieces the size of the shorter one so Karatsuba
+// and Toom-3 still get balanced operands. If both operands are the same word,
+// it's a square, and each method has a cheaper way to do it (see
+// word_square). Any scratch space comes from the arena, if there is one. The
+// result needs room for leftlen + rightlen limbs, and CANNOT overlap either
+// operand. Returns 1 on success or 0 if we ran out of memory.
+int word_mult(limb * result, const limb * left, long int leftlen,
+    const limb * right, long int rightlen, bignum_arena * arena) {
+    if ((left == right) && (leftlen == rightlen) &&
+        (rightlen < SQUARE_KARATSUBA_THRESHOLD)) {
+        word_square_basecase(result, left, leftlen);
+        return 1;
+    }
+    if (leftlen < rightlen) {
+        const limb * temp_ptr = left;
+        long int temp_len = leftlen;
+        left = right;
+        leftlen = rightlen;
+        right = temp_ptr;
+        rightlen = temp_len;
+    }
+    if (rightlen < KARATSUBA_THRESHOLD) {
+        word_mult_basecase(result, left, leftlen, right, rightlen);
+        return 1;
+    }
+    else if ((rightlen >= NTT_THRESHOLD) &&
+        ((leftlen + rightlen - 1L) <= NTT_MAX_LENGTH)) {
+        return word_mult_ntt(result, left, leftlen, right, rightlen, arena);
+    }
+    else if ((rightlen >= TOOM3_THRESHOLD) &&
+        (rightlen > (2L * ((leftlen + 2L) / 3L)))) {
+        return word_mult_toom3(result, left, leftlen, right, rightlen, arena);
+    }
+    else if (rightlen > ((leftlen + 1L) / 2L)) {
+        return word_mult_karatsuba(result, left, leftlen, right, rightlen,
+            arena);
+    }
+    else {
+        // Unbalanced: multiply each rightlen-sized piece of the left word by
+        // the whole right word, and add the partial products into place.
+        limb * temp_word = arena_take(arena, 2L * rightlen);
+        if (temp_word == 0) { return 0; }
+        long int i, piecelen;
+        for (i = 0L; i < (leftlen + rightlen); i++) { result[i] = 0; }
+        for (i = 0L; i < leftlen; i += rightlen) {
+            piecelen = (((leftlen - i) < rightlen) ? (leftlen - i) : rightlen);
+            if (word_mult(temp_word, left + i, piecelen, right, rightlen,
+                arena) == 0) {
+                arena_give(arena, temp_word, 2L * rightlen);
+                return 0;
+            }
+            word_add(result + i, result + i, leftlen + rightlen - i, temp_word,
+                piecelen + rightlen);
+        }
+        arena_give(arena, temp_word, 2L * rightlen);
+        return 1;
+    }
+}
+
+// Multiplies two words using the schoolbook shift-and-add method. The result
+// needs room for leftlen + rightlen limbs, and CANNOT overlap either operand.
+// Like before, if a limb of the right operand is zero, we can just skip it.
+void word_mult_basecase(limb * result, const limb * left, long int leftlen,
+    const limb * right, long int rightlen) {
+    long int i;
+    for (i = 0L; i < leftlen; i++) { result[i] = 0; }
+    for (i = 0L; i < rightlen; i++) {
+        if (right[i] != 0) {
+            result[i + leftlen] = word_addmul_1(result + i, left, leftlen, right[i]);
+        }
+        else { result[i + leftlen] = 0; }
+    }
+    return;
+}
+
+// Squares a word. This is just word_mult with the word passed in as both
+// operands, which is how it knows to take the shortcuts: the schoolbook
+// method only has to work out each cross product once, Karatsuba and Toom-3
+// only have to evaluate the halves or thirds once (and their pieces are
+// squares too, so it carries all the way down), and NTT only has to
+// transform once. The result needs room for 2 * length limbs, and CANNOT
+// overlap the operand. Returns 1 on success or 0 if we ran out of memory.
+int word_square(limb * result, const limb * word, long int length,
+    bignum_arena * arena) {
+    return word_mult(result, word, length, word, length, arena);
+}
+
+// Squares a word using the schoolbook method, but since a[i]a[j] and a[j]a[i]
+// are the same, only the products above the diagonal are added up, then the
+// total is doubled and the squares along the diagonal are added in. That's
+// about half the limb products of word_mult_basecase. The result needs room
+// for 2 * length limbs, and CANNOT overlap the operand.
+void word_square_basecase(limb * result, const limb * word, long int length) {
+    long int i;
+    for (i = 0L; i < (2L * length); i++) { result[i] = 0; }
+    for (i = 0L; i < (length - 1L); i++) {
+        if (word[i] != 0) {
+            result[i + length] = word_addmul_1(result + (2L * i) + 1L,
+                word + i + 1L, length - i - 1L, word[i]);
+        }
+    }
+    word_add_n(result, result, result, 2L * length);
+
+    // Each diagonal square is two limbs, and adding it (and the carry) to the
+    // two limbs already there always fits in 64 bits.
+    uint64_t carry = 0;
+    for (i = 0L; i < length; i++) {
+        uint64_t square = (uint64_t)word[i] * word[i];
+        uint64_t sum = result[2L * i] + (square % LIMB_BASE) + carry;
+        result[2L * i] = (limb)(sum % LIMB_BASE);
+        sum = result[(2L * i) + 1L] + (square / LIMB_BASE) + (sum / LIMB_BASE);
+        result[(2L * i) + 1L] = (limb)(sum % LIMB_BASE);
+        carry = sum / LIMB_BASE;
+    }
+    return;
+}
+
+// Multiplies two words using Karatsuba's method. Each word is split in half
+// at h limbs, so left = a1 * B^h + a0 and right = b1 * B^h + b0. Then
+// left * right = a1b1 * B^2h + ((a0 + a1)(b0 + b1) - a0b0 - a1b1) * B^h + a0b0,
+// which only needs three half-size multiplications instead of four. We use
+// the sums rather than the differences of the halves so that nothing ever
+// goes negative. Assumes leftlen >= rightlen > h, where h is half of leftlen
+// (rounded up). The halves are multiplied through word_mult, so they recurse.
+int word_mult_karatsuba(limb * result, const limb * left, long int leftlen,
+    const limb * right, long int rightlen, bignum_arena * arena) {
+    long int half = (leftlen + 1L) / 2L;
+    long int lefthigh = leftlen - half;
+    long int righthigh = rightlen - half;
+    limb * temp_word = arena_take(arena, (4L * half) + 4L);
+    if (temp_word == 0) { return 0; }
+    limb * leftsum = temp_word;
+    limb * rightsum = leftsum + half + 1L;
+    limb * middle = rightsum + half + 1L;
+
+    // The low and high products go straight into place in the result, since
+    // they cover exactly the limbs 0 to 2h and 2h to the end.
+    int retval = word_mult(result, left, half, right, half, arena);
+    if (retval == 1) {
+        retval = word_mult(result + (2L * half), left + half, lefthigh,
+            right + half, righthigh, arena);
+    }
+
+    // Now the middle product, from which we take away the other two.
+    // For a square, both sums are the same, so the middle is a square too.
+    leftsum[half] = word_add(leftsum, left, half, left + half, lefthigh);
+    if ((left == right) && (leftlen == rightlen)) { rightsum = leftsum; }
+    else {
+        rightsum[half] = word_add(rightsum, right, half, right + half, righthigh);
+    }
+    if (retval == 1) {
+        retval = word_mult(middle, leftsum, half + 1L, rightsum, half + 1L,
+            arena);
+    }
+    if (retval == 1) {
+        word_sub(middle, middle, 2L * half + 2L, result, 2L * half);
+        word_sub(middle, middle, 2L * half + 2L, result + (2L * half),
+            lefthigh + righthigh);
+        long int middlelen = leftlen + rightlen - half;
+        if (middlelen > ((2L * half) + 1L)) { middlelen = (2L * half) + 1L; }
+        word_add(result + half, result + half, leftlen + rightlen - half,
+            middle, middlelen);
+    }
+    arena_give(arena, temp_word, (4L * half) + 4L);
+    return retval;
+}
+
+// Multiplies two words using the Toom-3 method, which splits each word into
+// thirds of k limbs and treats them as quadratics in x = B^k, so the product
+// is a quartic c4x^4 + c3x^3 + c2x^2 + c1x + c0. Evaluating both quadratics
+// at five points and multiplying pointwise gives us five products of about a
+// third of the size, and then the c's can be solved for. The usual choice of
+// points includes -1, which would mean dealing with negative numbers, so we
+// use 0, 1, 2, 1/2 (scaled up by 4 to keep it whole), and infinity instead:
+//   W0 = c0, Winf = c4, W1 = c0 + c1 + c2 + c3 + c4,
+//   W2 = c0 + 2c1 + 4c2 + 8c3 + 16c4, Wh = 16c0 + 8c1 + 4c2 + 2c3 + c4.
+// Since every c is positive, the steps to solve for them can be ordered so
+// that every intermediate value is positive too:
+//   S1 = W1 - c0 - c4 = c1 + c2 + c3
+//   S2 = (W2 - c0 - 16c4) / 2 = c1 + 2c2 + 4c3, T2 = S2 - S1 = c2 + 3c3
+//   Sh = (Wh - 16c0 - c4) / 2 = 4c1 + 2c2 + c3, Th = Sh - S1 = 3c1 + c2
+//   c2 = 3S1 - T2 - Th, c3 = (T2 - c2) / 3, c1 = (Th - c2) / 3
+// The divisions are all exact, so they're just short divisions. Assumes
+// leftlen >= rightlen > 2k, where k is a third of leftlen (rounded up).
+int word_mult_toom3(limb * result, const limb * left, long int leftlen,
+    const limb * right, long int rightlen, bignum_arena * arena) {
+    long int third = (leftlen + 2L) / 3L;
+    long int lefthigh = leftlen - (2L * third);
+    long int righthigh = rightlen - (2L * third);
+    long int evallen = third + 1L;
+    long int prodlen = (2L * third) + 2L;
+    long int i;
+    limb * temp_word = arena_take(arena, (4L * evallen) + (4L * prodlen));
+    if (temp_word == 0) { return 0; }
+    limb * lefteval = temp_word;
+    limb * righteval = lefteval + evallen;
+    limb * leftscratch = righteval + evallen;
+    limb * rightscratch = leftscratch + evallen;
+    limb * w1 = rightscratch + evallen;
+    limb * w2 = w1 + prodlen;
+    limb * wh = w2 + prodlen;
+    limb * scratch = wh + prodlen;
+    const limb * a0 = left;
+    const limb * a1 = left + third;
+    const limb * a2 = left + (2L * third);
+    const limb * b0 = right;
+    const limb * b1 = right + third;
+    const limb * b2 = right + (2L * third);
+    int square = ((left == right) && (leftlen == rightlen));
+
+    // c0 and c4 go straight into the result, and the limbs between them are
+    // cleared so the middle coefficients can be added on top.
+    int retval = word_mult(result, a0, third, b0, third, arena);
+    if (retval == 1) {
+        retval = word_mult(result + (4L * third), a2, lefthigh, b2, righthigh,
+            arena);
+    }
+    for (i = 2L * third; i < (4L * third); i++) { result[i] = 0; }
+    limb * c0 = result;
+    limb * c4 = result + (4L * third);
+    long int c4len = lefthigh + righthigh;
+
+    // W1: evaluate at 1, which is just the sum of the thirds
+    lefteval[third] = word_add(lefteval, a0, third, a1, third);
+    lefteval[third] += word_add(lefteval, lefteval, third, a2, lefthigh);
+    if (square == 1) { righteval = lefteval; }
     else {
-        bignum * tempnum = bignum_init(resultnum->precision);
-        if (tempnum == 0) { return 0; }
-        if (bignum_set_int(tempnum, rightint) == 0) {
-            bignum_clear(tempnum);
+        righteval[third] = word_add(righteval, b0, third, b1, third);
+        righteval[third] += word_add(righteval, righteval, third, b2, righthigh);
+    }
+    if (retval == 1) {
+        retval = word_mult(w1, lefteval, evallen, righteval, evallen, arena);
+    }
+
+    // W2: evaluate at 2, or a0 + 2a1 + 4a2, using Horner's rule
+    for (i = 0L; i < lefthigh; i++) { leftscratch[i] = a2[i]; }
+    for (; i < evallen; i++) { leftscratch[i] = 0; }
+    word_mul_1(leftscratch, leftscratch, evallen, 2);
+    word_add(leftscratch, leftscratch, evallen, a1, third);
+    word_mul_1(leftscratch, leftscratch, evallen, 2);
+    word_add(lefteval, leftscratch, evallen, a0, third);
+    if (square == 0) {
+        for (i = 0L; i < righthigh; i++) { rightscratch[i] = b2[i]; }
+        for (; i < evallen; i++) { rightscratch[i] = 0; }
+        word_mul_1(rightscratch, rightscratch, evallen, 2);
+        word_add(rightscratch, rightscratch, evallen, b1, third);
+        word_mul_1(rightscratch, rightscratch, evallen, 2);
+        word_add(righteval, rightscratch, evallen, b0, third);
+    }
+    if (retval == 1) {
+        retval = word_mult(w2, lefteval, evallen, righteval, evallen, arena);
+    }
+
+    // Wh: evaluate at 1/2 and scale by 4, or 4a0 + 2a1 + a2
+    for (i = 0L; i < third; i++) { leftscratch[i] = a0[i]; }
+    leftscratch[third] = 0;
+    word_mul_1(leftscratch, leftscratch, evallen, 2);
+    word_add(leftscratch, leftscratch, evallen, a1, third);
+    word_mul_1(leftscratch, leftscratch, evallen, 2);
+    word_add(lefteval, leftscratch, evallen, a2, lefthigh);
+    if (square == 0) {
+        for (i = 0L; i < third; i++) { rightscratch[i] = b0[i]; }
+        rightscratch[third] = 0;
+        word_mul_1(rightscratch, rightscratch, evallen, 2);
+        word_add(rightscratch, rightscratch, evallen, b1, third);
+        word_mul_1(rightscratch, rightscratch, evallen, 2);
+        word_add(righteval, rightscratch, evallen, b2, righthigh);
+    }
+    if (retval == 1) {
+        retval = word_mult(wh, lefteval, evallen, righteval, evallen, arena);
+    }
+    if (retval == 0) {
+        arena_give(arena, temp_word, (4L * evallen) + (4L * prodlen));
+        return 0;
+    }
+
+    // Interpolate. w1 becomes S1, w2 becomes T2, and wh becomes Th.
+    word_sub(w1, w1, prodlen, c0, 2L * third);
+    word_sub(w1, w1, prodlen, c4, c4len);
+    word_sub(w2, w2, prodlen, c0, 2L * third);
+    scratch[c4len] = word_mul_1(scratch, c4, c4len, 16);
+    word_sub(w2, w2, prodlen, scratch, c4len + 1L);
+    word_divide_1(w2, w2, prodlen, 2);
+    word_sub(w2, w2, prodlen, w1, prodlen);
+    scratch[2L * third] = word_mul_1(scratch, c0, 2L * third, 16);
+    word_sub(wh, wh, prodlen, scratch, (2L * third) + 1L);
+    word_sub(wh, wh, prodlen, c4, c4len);
+    word_divide_1(wh, wh, prodlen, 2);
+    word_sub(wh, wh, prodlen, w1, prodlen);
+
+    // Now scratch becomes c2, then w2 and wh become c3 and c1.
+    word_mul_1(scratch, w1, prodlen, 3);
+    word_sub(scratch, scratch, prodlen, w2, prodlen);
+    word_sub(scratch, scratch, prodlen, wh, prodlen);
+    word_sub(w2, w2, prodlen, scratch, prodlen);
+    word_divide_1(w2, w2, prodlen, 3);
+    word_sub(wh, wh, prodlen, scratch, prodlen);
+    word_divide_1(wh, wh, prodlen, 3);
+
+    // Finally, add the middle coefficients into place. Each one is shorter
+    // than prodlen once its leading zeros are ignored, and the total has to
+    // fit in the result, so we never add more limbs than are left.
+    long int total = leftlen + rightlen;
+    word_add(result + third, result + third, total - third, wh,
+        ((prodlen < (total - third)) ? prodlen : (total - third)));
+    word_add(result + (2L * third), result + (2L * third), total - (2L * third),
+        scratch, ((prodlen < (total - (2L * third))) ? prodlen :
+        (total - (2L * third))));
+    word_add(result + (3L * third), result + (3L * third), total - (3L * third),
+        w2, ((prodlen < (total - (3L * third))) ? prodlen :
+        (total - (3L * third))));
+    arena_give(arena, temp_word, (4L * evallen) + (4L * prodlen));
+    return 1;
+}
+
+// Raises a number to a power modulo one of the NTT primes, by squaring.
+// Since the primes are all under 2^30, every product fits in 64 bits.
+limb ntt_power(limb base, uint64_t exponent, limb prime) {
+    uint64_t result = 1;
+    uint64_t square = base % prime;
+    while (exponent > 0) {
+        if ((exponent & 1) == 1) { result = (result * square) % prime; }
+        square = (square * square) % prime;
+        exponent >>= 1;
+    }
+    return (limb)result;
+}
+
+// Runs an in-place number-theoretic transform (a Fourier transform where all
+// the arithmetic is done modulo a prime, so there's no rounding error to worry
+// about) over a word of residues whose length is a power of two. This is the
+// usual iterative radix-2 version: shuffle into bit-reversed order, then
+// combine pairs of ever-bigger blocks. The powers of the root of unity are
+// worked out once up front into the roots scratch space, which needs room for
+// length / 2 residues. The inverse transform uses the inverse root and divides
+// by the length at the end.
+void ntt_transform(limb * word, long int length, limb prime, int inverse,
+    limb * roots) {
+    long int i, j, block, half, stride;
+    for (i = 1L, j = 0L; i < length; i++) {
+        long int bit = length >> 1;
+        for (; (j & bit) != 0L; bit >>= 1) { j ^= bit; }
+        j ^= bit;
+        if (i < j) {
+            limb temp_limb = word[i];
+            word[i] = word[j];
+            word[j] = temp_limb;
+        }
+    }
+    limb root = ntt_power(NTT_ROOT, (prime - 1U) / (uint64_t)length, prime);
+    if (inverse == 1) { root = ntt_power(root, prime - 2U, prime); }
+    roots[0] = 1;
+    for (i = 1L; i < (length / 2L); i++) {
+        roots[i] = (limb)(((uint64_t)roots[i - 1L] * root) % prime);
+    }
+    for (block = 2L; block <= length; block <<= 1) {
+        half = block / 2L;
+        stride = length / block;
+        for (i = 0L; i < length; i += block) {
+            for (j = 0L; j < half; j++) {
+                limb even = word[i + j];
+                limb odd = (limb)(((uint64_t)word[i + j + half] *
+                    roots[j * stride]) % prime);
+                word[i + j] = ((even + odd) >= prime) ? (even + odd - prime) :
+                    (even + odd);
+                word[i + j + half] = (even >= odd) ? (even - odd) :
+                    (even + prime - odd);
+            }
+        }
+    }
+    if (inverse == 1) {
+        limb scale = ntt_power((limb)(length % prime), prime - 2U, prime);
+        for (i = 0L; i < length; i++) {
+            word[i] = (limb)(((uint64_t)word[i] * scale) % prime);
+        }
+    }
+    return;
+}
+
+// Multiplies two words with number-theoretic transforms. A product's columns
+// (before carrying) can get as big as rightlen * 10^18, so one prime isn't
+// enough to hold them. Instead the whole convolution is done three times,
+// modulo three different primes, and then the Chinese remainder theorem
+// stitches each column back together, using Garner's method so that nothing
+// bigger than 64 bits is ever needed:
+//   x = r1 + p1 * (t1 + p2 * t2),
+//   t1 = (r2 - r1) / p1 mod p2, t2 = (r3 - r1 - p1 * t1) / (p1 * p2) mod p3.
+// Since x can be up to 86 bits, p1 * (t1 + p2 * t2) is split again at 10^9
+// before being carried into the result. The total length (rounded up to a
+// power of two) can't be more than NTT_MAX_LENGTH; word_mult checks for that.
+// The result needs room for leftlen + rightlen limbs, and CANNOT overlap
+// either operand. Returns 1 on success or 0 if we ran out of memory.
+int word_mult_ntt(limb * result, const limb * left, long int leftlen,
+    const limb * right, long int rightlen, bignum_arena * arena) {
+    limb primes[3] = { NTT_PRIME_1, NTT_PRIME_2, NTT_PRIME_3 };
+    long int columns = leftlen + rightlen - 1L;
+    long int length = 1L;
+    long int i, p;
+    while (length < columns) { length <<= 1; }
+    long int templen = (3L * columns) + (2L * length) + (length / 2L) + 1L;
+    limb * temp_word = arena_take(arena, templen);
+    if (temp_word == 0) { return 0; }
+    limb * residues = temp_word;
+    limb * lefttrans = residues + (3L * columns);
+    limb * righttrans = lefttrans + length;
+    limb * roots = righttrans + length;
+    int square = ((left == right) && (leftlen == rightlen));
+
+    // Convolve modulo each prime in turn, keeping just the residues
+    for (p = 0L; p < 3L; p++) {
+        for (i = 0L; i < length; i++) {
+            lefttrans[i] = ((i < leftlen) ? (left[i] % primes[p]) : 0);
+            if (square == 0) {
+                righttrans[i] = ((i < rightlen) ? (right[i] % primes[p]) : 0);
+            }
+        }
+        ntt_transform(lefttrans, length, primes[p], 0, roots);
+        if (square == 1) {
+            for (i = 0L; i < length; i++) {
+                lefttrans[i] = (limb)(((uint64_t)lefttrans[i] * lefttrans[i]) %
+                    primes[p]);
+            }
+        }
+        else {
+            ntt_transform(righttrans, length, primes[p], 0, roots);
+            for (i = 0L; i < length; i++) {
+                lefttrans[i] = (limb)(((uint64_t)lefttrans[i] * righttrans[i]) %
+                    primes[p]);
+            }
+        }
+        ntt_transform(lefttrans, length, primes[p], 1, roots);
+        for (i = 0L; i < columns; i++) {
+            residues[(p * columns) + i] = lefttrans[i];
+        }
+    }
+
+    // Reconstruct each column and carry it into the result
+    uint64_t inverse12 = ntt_power(NTT_PRIME_1 % NTT_PRIME_2, NTT_PRIME_2 - 2U,
+        NTT_PRIME_2);
+    uint64_t inverse123 = ntt_power((limb)(((uint64_t)(NTT_PRIME_1 % NTT_PRIME_3) *
+        (NTT_PRIME_2 % NTT_PRIME_3)) % NTT_PRIME_3), NTT_PRIME_3 - 2U, NTT_PRIME_3);
+    uint64_t carry = 0;
+    for (i = 0L; i < columns; i++) {
+        uint64_t r1 = residues[i];
+        uint64_t r2 = residues[columns + i];
+        uint64_t r3 = residues[(2L * columns) + i];
+        uint64_t t1 = (((r2 + NTT_PRIME_2) - (r1 % NTT_PRIME_2)) * inverse12) %
+            NTT_PRIME_2;
+        uint64_t t2 = (((r3 + NTT_PRIME_3) - ((r1 + (NTT_PRIME_1 * t1)) %
+            NTT_PRIME_3)) * inverse123) % NTT_PRIME_3;
+        uint64_t upper = t1 + (NTT_PRIME_2 * t2);
+        uint64_t low = r1 + (NTT_PRIME_1 * (upper % LIMB_BASE)) + (carry % LIMB_BASE);
+        result[i] = (limb)(low % LIMB_BASE);
+        carry = (carry / LIMB_BASE) + (low / LIMB_BASE) +
+            (NTT_PRIME_1 * (upper / LIMB_BASE));
+    }
+    result[columns] = (limb)carry;
+    arena_give(arena, temp_word, templen);
+    return 1;
+}
+
+// Divides a word by a single limb, starting from the top, and returns the
+// remainder. Since the remainder is always smaller than the divisor, the
+// running value never needs more than 64 bits. The quotient may be the same
+// as the numerator.
+limb word_divide_1(limb * quotient, limb * numerator, long int length,
+    limb divisor) {
+    long int i;
+    uint64_t remainder = 0;
+    for (i = length - 1L; i >= 0L; i--) {
+        uint64_t current = (remainder * LIMB_BASE) + numerator[i];
+        quotient[i] = (limb)(current / divisor);
+        remainder = current % divisor;
+    }
+    return (limb)remainder;
+}
+
+// Divides one word by another using long division, one quotient limb at a
+// time, the way Knuth lays it out in Algorithm D. The remainder word holds
+// the numerator going in (with one extra zero limb on top, so it needs
+// numlen + 1 limbs of space) and what's left of it coming out. The quotient
+// gets numlen - denomlen + 1 limbs, and the scratch space needs denomlen + 1
+// limbs. The denominator's top limb can't be zero. First, both words are
+// multiplied by the same small factor so that the denominator's top limb is
+// at least half of B. Then each quotient limb can be guessed from just the
+// top two limbs of what's left of the numerator and the top limb of the
+// denominator, and checking against the second limb of the denominator
+// means the guess is too big by at most one. If it still is, the
+// subtraction goes negative, and we add the denominator back once. At the
+// end, the remainder (which fits in denomlen limbs by then) is divided back
+// down by the factor.
+void word_divide(limb * quotient, limb * remainder, long int numlen,
+    limb * denominator, long int denomlen, limb * scratch) {
+    long int i;
+    if (denomlen == 1L) {
+        remainder[0] = word_divide_1(quotient, remainder, numlen, denominator[0]);
+        for (i = 1L; i <= numlen; i++) { remainder[i] = 0; }
+        return;
+    }
+    limb factor = LIMB_BASE / (denominator[denomlen - 1L] + 1);
+    limb * normal = scratch;
+    word_mul_1(normal, denominator, denomlen, factor);
+    remainder[numlen] = word_mul_1(remainder, remainder, numlen, factor);
+    uint64_t top = normal[denomlen - 1L];
+    uint64_t second = normal[denomlen - 2L];
+    for (i = numlen - denomlen; i >= 0L; i--) {
+        limb * current = remainder + i;
+        uint64_t leading = ((uint64_t)current[denomlen] * LIMB_BASE) +
+            current[denomlen - 1L];
+        uint64_t guess = leading / top;
+        uint64_t rest = leading % top;
+        while ((guess >= LIMB_BASE) || ((guess * second) >
+            ((rest * LIMB_BASE) + current[denomlen - 2L]))) {
+            guess--;
+            rest += top;
+            if (rest >= LIMB_BASE) { break; }
+        }
+        limb borrow = word_submul_1(current, normal, denomlen, (limb)guess);
+        if (borrow > current[denomlen]) {
+            guess--;
+            limb carry = word_add_n(current, current, normal, denomlen);
+            current[denomlen] = current[denomlen] + carry - borrow;
+        }
+        else { current[denomlen] -= borrow; }
+        quotient[i] = (limb)guess;
+    }
+    word_divide_1(remainder, remainder, denomlen, factor);
+    return;
+}
+
+// Works out the reciprocal of a word with Newton's method. Given a
+// denominator of length limbs (its top limb can't be zero), the result gets
+// roughly B^(2 * length) / denominator, which takes length + 2 limbs, where B
+// is 10^9. It isn't exact, but it's within a few units of the last limb,
+// which is all word_divide_newton needs. Below NEWTON_THRESHOLD limbs it's
+// just done with long division. Above that, we take the reciprocal of the top
+// h limbs (a little over half) recursively, and then one Newton step,
+// Y = Y0 + Y0 * (1 - T * Y0), doubles the number of correct limbs. In whole
+// numbers, with Y0 = Yh * B^s, s = length - h, and E = B^(length + h) - T * Yh,
+// that step becomes Y = Y0 + (Yh * E) / B^2h. E can come out negative, in
+// which case we subtract the correction instead. Returns 1 on success or 0 if
+// we ran out of memory.
+int word_reciprocal(limb * result, limb * denominator, long int length,
+    bignum_arena * arena) {
+    long int i;
+    if (length < NEWTON_THRESHOLD) {
+        long int templen = (2L * length) + 2L + length + 1L;
+        limb * temp_word = arena_take(arena, templen);
+        if (temp_word == 0) { return 0; }
+        for (i = 0L; i < (2L * length) + 2L; i++) { temp_word[i] = 0; }
+        temp_word[2L * length] = 1;
+        word_divide(result, temp_word, (2L * length) + 1L, denominator, length,
+            temp_word + (2L * length) + 2L);
+        arena_give(arena, temp_word, templen);
+        return 1;
+    }
+    long int half = (length + 4L) / 2L;
+    long int shift = length - half;
+    long int prodlen = length + half + 2L;
+    long int templen = (2L * prodlen) + (2L * half) + 4L;
+    limb * temp_word = arena_take(arena, templen);
+    if (temp_word == 0) { return 0; }
+    limb * product = temp_word;
+    limb * correction = product + prodlen;
+    limb * halfrecip = correction + prodlen + half + 2L;
+
+    // Start from the reciprocal of the top limbs, shifted into place
+    if (word_reciprocal(halfrecip, denominator + shift, half, arena) == 0) {
+        arena_give(arena, temp_word, templen);
+        return 0;
+    }
+    for (i = 0L; i < shift; i++) { result[i] = 0; }
+    for (i = 0L; i < (half + 2L); i++) { result[shift + i] = halfrecip[i]; }
+
+    // Find E = B^(length + h) - T * Yh, keeping track of its sign
+    if (word_mult(product, denominator, length, halfrecip, half + 2L,
+        arena) == 0) {
+        arena_give(arena, temp_word, templen);
+        return 0;
+    }
+    int negative = 0;
+    for (i = length + half; i < prodlen; i++) {
+        if (product[i] != 0) { negative = 1; }
+    }
+    if (negative == 1) {
+        word_sub_1(product + length + half, product + length + half, 2L, 1);
+    }
+    else {
+        // B^(length + h) - P is the same as (B^(length + h) - 1) - P + 1,
+        // and the first part can be done limb by limb without borrowing.
+        for (i = 0L; i < (length + half); i++) {
+            product[i] = (LIMB_BASE - 1U) - product[i];
+        }
+        word_add_1(product, product, length + half, 1);
+    }
+    long int errorlen = prodlen;
+    while ((errorlen > 0L) && (product[errorlen - 1L] == 0)) { errorlen--; }
+
+    // Then the Newton step itself, adding or subtracting Yh * E / B^2h
+    if (errorlen > 0L) {
+        if (word_mult(correction, halfrecip, half + 2L, product, errorlen,
+            arena) == 0) {
+            arena_give(arena, temp_word, templen);
             return 0;
         }
-        int retval = bignum_divide(resultnum, leftnum, tempnum);
-        bignum_clear(tempnum);
-        return retval;
+        long int corrlen = half + 2L + errorlen - (2L * half);
+        if (corrlen > 0L) {
+            if (corrlen > (length + 2L)) { corrlen = length + 2L; }
+            if (negative == 1) {
+                word_sub(result, result, length + 2L, correction + (2L * half),
+                    corrlen);
+            }
+            else {
+                word_add(result, result, length + 2L, correction + (2L * half),
+                    corrlen);
+            }
+        }
+    }
+    arena_give(arena, temp_word, templen);
+    return 1;
+}
+
+// Divides one word by another by multiplying the numerator by the
+// denominator's reciprocal, so at high precision division only costs a few
+// multiplications instead of being quadratic. The reciprocal needs one more
+// limb than the quotient has, so we either take it of just the top limbs of
+// the denominator, or, if the denominator is shorter than that, of the
+// denominator with zero limbs tacked on the bottom. Since the reciprocal is
+// approximate, the quotient might be off by a few, so we finish with an exact
+// check: multiply back by the denominator, and step the quotient down while
+// the product is too big, then up while what's left over is still at least
+// the denominator. That way we get exactly the same truncated quotient as
+// long division would. The quotient gets numlen - denomlen + 1 limbs, and the
+// denominator's top limb can't be zero. Returns 1 on success or 0 if we ran
+// out of memory.
+int word_divide_newton(limb * quotient, limb * numerator, long int numlen,
+    limb * denominator, long int denomlen, bignum_arena * arena) {
+    long int i;
+    long int quotlen = numlen - denomlen + 1L;
+    long int reciplen = quotlen + 1L;
+    long int topdrop = denomlen - reciplen;
+    long int skip = ((topdrop > 0L) ? topdrop : 0L);
+    while ((skip < numlen) && (numerator[skip] == 0)) { skip++; }
+    long int usedlen = numlen - skip;
+    if (usedlen == 0L) {
+        for (i = 0L; i < quotlen; i++) { quotient[i] = 0; }
+        return 1;
+    }
+    long int padlen = ((topdrop < 0L) ? reciplen : 0L);
+    long int prodlen = usedlen + reciplen + 2L;
+    long int checklen = quotlen + 1L + denomlen;
+    long int templen = reciplen + 2L + prodlen + quotlen + 1L + checklen +
+        padlen;
+    limb * temp_word = arena_take(arena, templen);
+    if (temp_word == 0) { return 0; }
+    for (i = 0L; i < templen; i++) { temp_word[i] = 0; }
+    limb * reciprocal = temp_word;
+    limb * product = reciprocal + reciplen + 2L;
+    limb * estimate = product + prodlen;
+    limb * check = estimate + quotlen + 1L;
+    limb * top = denominator + topdrop;
+    if (topdrop < 0L) {
+        top = check + checklen;
+        for (i = 0L; i < denomlen; i++) { top[i - topdrop] = denominator[i]; }
+    }
+
+    // Estimate the quotient: numerator * Y / B^(2 * reciplen + topdrop). Any
+    // limbs we skipped on the bottom of the numerator (the ones too small to
+    // matter, plus any zeros) are made up for by where we start reading the
+    // product.
+    if (word_reciprocal(reciprocal, top, reciplen, arena) == 0) {
+        arena_give(arena, temp_word, templen);
+        return 0;
+    }
+    if (word_mult(product, numerator + skip, usedlen, reciprocal,
+        reciplen + 2L, arena) == 0) {
+        arena_give(arena, temp_word, templen);
+        return 0;
+    }
+    long int start = (2L * reciplen) + topdrop - skip;
+    for (i = 0L; i <= quotlen; i++) {
+        long int index = start + i;
+        estimate[i] = (((index >= 0L) && (index < prodlen)) ? product[index] : 0);
+    }
+
+    // Multiply back and nudge the estimate until it's exact
+    if (word_mult(check, estimate, quotlen + 1L, denominator, denomlen,
+        arena) == 0) {
+        arena_give(arena, temp_word, templen);
+        return 0;
+    }
+    while ((check[numlen] != 0) || (check[numlen + 1L] != 0) ||
+        (word_compare(check, numerator, numlen) > 0)) {
+        word_sub_1(estimate, estimate, quotlen + 1L, 1);
+        word_sub(check, check, checklen, denominator, denomlen);
+    }
+    word_sub(check, numerator, numlen, check, numlen);
+    int bigger = 1;
+    while (bigger == 1) {
+        long int remlen = numlen;
+        while ((remlen > 0L) && (check[remlen - 1L] == 0)) { remlen--; }
+        if (remlen < denomlen) { bigger = 0; }
+        else if ((remlen == denomlen) &&
+            (word_compare(check, denominator, denomlen) < 0)) { bigger = 0; }
+        else {
+            word_add_1(estimate, estimate, quotlen + 1L, 1);
+            word_sub(check, check, numlen, denominator, denomlen);
+        }
     }
+    for (i = 0L; i < quotlen; i++) { quotient[i] = estimate[i]; }
+    arena_give(arena, temp_word, templen);
+    return 1;
+}
+
+// Times the schoolbook, Karatsuba, Toom-3, and NTT methods against each other
+// over a range of word sizes, so we can see where each one starts winning on
+// this particular machine and set the thresholds in word_mult to match.
+// Each method is only forced at the top level; the pieces it multiplies are
+// handed back to word_mult like normal. Each size is repeated until it's run
+// for at least a twentieth of a second, which is plenty for clock().
+void word_mult_benchmark(void) {
+    long int sizes[] = { 8L, 12L, 16L, 20L, 24L, 32L, 40L, 48L, 64L, 96L, 128L,
+        192L, 256L, 384L, 512L, 768L, 1024L, 1536L, 2048L, 3072L, 4096L, 0L };
+    const char * names[] = { "schoolbook", "karatsuba", "toom-3", "ntt" };
+    long int maxlen = 4096L;
+    limb * left = (limb *)malloc(maxlen * sizeof(limb));
+    limb * right = (limb *)malloc(maxlen * sizeof(limb));
+    limb * result = (limb *)malloc(2L * maxlen * sizeof(limb));
+    if ((left == 0) || (right == 0) || (result == 0)) {
+        printf("Error allocating memory. Now exiting.\n");
+        return;
+    }
+    long int i, j, reps;
+    uint64_t seed = 12345;
+    for (i = 0L; i < maxlen; i++) {
+        seed = (seed * 6364136223846793005ULL) + 1442695040888963407ULL;
+        left[i] = (limb)((seed >> 32) % LIMB_BASE);
+        seed = (seed * 6364136223846793005ULL) + 1442695040888963407ULL;
+        right[i] = (limb)((seed >> 32) % LIMB_BASE);
+    }
+    printf("Microseconds per multiplication (thresholds are %ld, %ld and %ld limbs)\n",
+        (long int)KARATSUBA_THRESHOLD, (long int)TOOM3_THRESHOLD,
+        (long int)NTT_THRESHOLD);
+    printf("  limbs   digits  schoolbook   karatsuba      toom-3         ntt  fastest\n");
+    for (i = 0L; sizes[i] > 0L; i++) {
+        long int n = sizes[i];
+        double best = 0.0;
+        int bestmethod = 0;
+        printf("%7ld %8ld", n, n * LIMB_DIGITS);
+        for (j = 0L; j < 4L; j++) {
+            long int clock_start = (long int)clock();
+            long int elapsed = 0L;
+            reps = 0L;
+            while (elapsed < (long int)(CLOCKS_PER_SEC / 20)) {
+                if (j == 0L) { word_mult_basecase(result, left, n, right, n); }
+                else if (j == 1L) { word_mult_karatsuba(result, left, n, right, n, 0); }
+                else if (j == 2L) { word_mult_toom3(result, left, n, right, n, 0); }
+                else { word_mult_ntt(result, left, n, right, n, 0); }
+                reps++;
+                elapsed = (long int)clock() - clock_start;
+            }
+            double micros = (1000000.0 * (double)elapsed) /
+                ((double)CLOCKS_PER_SEC * (double)reps);
+            if ((j == 0L) || (micros < best)) {
+                best = micros;
+                bestmethod = (int)j;
+            }
+            printf(" %11.2f", micros);
+        }
+        printf("  %s\n", names[bestmethod]);
+    }
+    free(left);
+    free(right);
+    free(result);
+    return;
+}
+
+// Like word_mult_benchmark, but for division: times long division against
+// Newton's method for dividing a 2n-limb word by an n-limb word, which is
+// what bignum_divide usually ends up doing. This is how NEWTON_THRESHOLD
+// was picked.
+void word_divide_benchmark(void) {
+    long int sizes[] = { 4L, 8L, 12L, 16L, 24L, 32L, 48L, 64L, 96L, 128L, 192L,
+        256L, 384L, 512L, 0L };
+    long int maxlen = 512L;
+    limb * numerator = (limb *)malloc(((2L * maxlen) + 1L) * sizeof(limb));
+    limb * remainder = (limb *)malloc(((2L * maxlen) + 1L) * sizeof(limb));
+    limb * denominator = (limb *)malloc(maxlen * sizeof(limb));
+    limb * quotient = (limb *)malloc((maxlen + 1L) * sizeof(limb));
+    limb * scratch = (limb *)malloc((maxlen + 1L) * sizeof(limb));
+    if ((numerator == 0) || (remainder == 0) || (denominator == 0) ||
+        (quotient == 0) || (scratch == 0)) {
+        printf("Error allocating memory. Now exiting.\n");
+        return;
+    }
+    long int i, j, k, reps;
+    uint64_t seed = 54321;
+    for (i = 0L; i < (2L * maxlen); i++) {
+        seed = (seed * 6364136223846793005ULL) + 1442695040888963407ULL;
+        numerator[i] = (limb)((seed >> 32) % LIMB_BASE);
+    }
+    for (i = 0L; i < maxlen; i++) {
+        seed = (seed * 6364136223846793005ULL) + 1442695040888963407ULL;
+        denominator[i] = (limb)((seed >> 32) % LIMB_BASE);
+    }
+    printf("\nMicroseconds per 2n by n division (threshold is %ld limbs)\n",
+        (long int)NEWTON_THRESHOLD);
+    printf("  limbs   digits  long division      newton  fastest\n");
+    for (i = 0L; sizes[i] > 0L; i++) {
+        long int n = sizes[i];
+        double micros[2];
+        denominator[n - 1L] += (denominator[n - 1L] == 0) ? 1 : 0;
+        printf("%7ld %8ld", n, n * LIMB_DIGITS);
+        for (j = 0L; j < 2L; j++) {
+            long int clock_start = (long int)clock();
+            long int elapsed = 0L;
+            reps = 0L;
+            while (elapsed < (long int)(CLOCKS_PER_SEC / 20)) {
+                if (j == 0L) {
+                    for (k = 0L; k < (2L * n); k++) { remainder[k] = numerator[k]; }
+                    remainder[2L * n] = 0;
+                    word_divide(quotient, remainder, 2L * n, denominator, n, scratch);
+                }
+                else {
+                    word_divide_newton(quotient, numerator, 2L * n, denominator, n,
+                        0);
+                }
+                reps++;
+                elapsed = (long int)clock() - clock_start;
+            }
+            micros[j] = (1000000.0 * (double)elapsed) /
+                ((double)CLOCKS_PER_SEC * (double)reps);
+        }
+        printf(" %14.2f %11.2f  %s\n", micros[0], micros[1],
+            ((micros[0] <= micros[1]) ? "long division" : "newton"));
+    }
+    free(numerator);
+    free(remainder);
+    free(denominator);
+    free(quotient);
+    free(scratch);
+    return;
 }